@@ -22,16 +22,21 @@
  * IN THE SOFTWARE.
  */
 
+#include <algorithm>
+#include <functional>
+
 #include "servicemodel.h"
 
 Q_DECLARE_METATYPE(QMdnsEngine::Service)
 
 ServiceModel::ServiceModel(QMdnsEngine::Server *server, const QByteArray &type)
-    : mBrowser(server, type, &cache)
+    : mBrowser(server, type, &cache),
+      mServices(mBrowser.services())
 {
-    connect(&mBrowser, &QMdnsEngine::Browser::serviceAdded, this, &ServiceModel::onServiceAdded);
-    connect(&mBrowser, &QMdnsEngine::Browser::serviceUpdated, this, &ServiceModel::onServiceUpdated);
-    connect(&mBrowser, &QMdnsEngine::Browser::serviceRemoved, this, &ServiceModel::onServiceRemoved);
+    updateRows();
+    connect(&mBrowser, &QMdnsEngine::Browser::servicesAdded, this, &ServiceModel::onServicesAdded);
+    connect(&mBrowser, &QMdnsEngine::Browser::servicesUpdated, this, &ServiceModel::onServicesUpdated);
+    connect(&mBrowser, &QMdnsEngine::Browser::servicesRemoved, this, &ServiceModel::onServicesRemoved);
 }
 
 int ServiceModel::rowCount(const QModelIndex &) const
@@ -60,38 +65,64 @@ QVariant ServiceModel::data(const QModelIndex &index, int role) const
     return QVariant();
 }
 
-void ServiceModel::onServiceAdded(const QMdnsEngine::Service &service)
+void ServiceModel::onServicesAdded(const QList<QMdnsEngine::Service> &services)
 {
-    beginInsertRows(QModelIndex(), mServices.count(), mServices.count());
-    mServices.append(service);
+    beginInsertRows(QModelIndex(), mServices.count(), mServices.count() + services.count() - 1);
+    for (const QMdnsEngine::Service &service : services) {
+        mRows.insert(serviceKey(service), mServices.count());
+        mServices.append(service);
+    }
     endInsertRows();
 }
 
-void ServiceModel::onServiceUpdated(const QMdnsEngine::Service &service)
+void ServiceModel::onServicesUpdated(const QList<QMdnsEngine::Service> &services)
 {
-    int i = findService(service.name());
-    if (i != -1) {
-        mServices.replace(i, service);
-        emit dataChanged(index(i), index(i));
+    int first = mServices.count();
+    int last = -1;
+    for (const QMdnsEngine::Service &service : services) {
+        int i = mRows.value(serviceKey(service), -1);
+        if (i != -1) {
+            mServices.replace(i, service);
+            first = qMin(first, i);
+            last = qMax(last, i);
+        }
+    }
+    if (last != -1) {
+        emit dataChanged(index(first), index(last));
     }
 }
 
-void ServiceModel::onServiceRemoved(const QMdnsEngine::Service &service)
+void ServiceModel::onServicesRemoved(const QList<QMdnsEngine::Service> &services)
 {
-    int i = findService(service.name());
-    if (i != -1) {
+    // Remove the rows from the bottom up so that the remaining indices stay
+    // valid, then renumber the rows that are left
+    QList<int> rows;
+    for (const QMdnsEngine::Service &service : services) {
+        int i = mRows.value(serviceKey(service), -1);
+        if (i != -1) {
+            rows.append(i);
+        }
+    }
+    std::sort(rows.begin(), rows.end(), std::greater<int>());
+    for (int i : rows) {
         beginRemoveRows(QModelIndex(), i, i);
         mServices.removeAt(i);
         endRemoveRows();
     }
+    if (!rows.isEmpty()) {
+        updateRows();
+    }
 }
 
-int ServiceModel::findService(const QByteArray &name)
+QByteArray ServiceModel::serviceKey(const QMdnsEngine::Service &service)
 {
-    for (auto i = mServices.constBegin(); i != mServices.constEnd(); ++i) {
-        if ((*i).name() == name) {
-            return i - mServices.constBegin();
-        }
+    return service.name() + "." + service.type();
+}
+
+void ServiceModel::updateRows()
+{
+    mRows.clear();
+    for (int i = 0; i < mServices.count(); ++i) {
+        mRows.insert(serviceKey(mServices.at(i)), i);
     }
-    return -1;
 }
@@ -26,6 +26,7 @@
 #define SERVICEMODEL_H
 
 #include <QAbstractListModel>
+#include <QHash>
 #include <QList>
 
 #include <qmdnsengine/browser.h>
@@ -46,17 +47,19 @@ public:
 
 private Q_SLOTS:
 
-    void onServiceAdded(const QMdnsEngine::Service &service);
-    void onServiceUpdated(const QMdnsEngine::Service &service);
-    void onServiceRemoved(const QMdnsEngine::Service &service);
+    void onServicesAdded(const QList<QMdnsEngine::Service> &services);
+    void onServicesUpdated(const QList<QMdnsEngine::Service> &services);
+    void onServicesRemoved(const QList<QMdnsEngine::Service> &services);
 
 private:
 
-    int findService(const QByteArray &name);
+    static QByteArray serviceKey(const QMdnsEngine::Service &service);
+    void updateRows();
 
     QMdnsEngine::Cache cache;
     QMdnsEngine::Browser mBrowser;
     QList<QMdnsEngine::Service> mServices;
+    QHash<QByteArray, int> mRows;
 };
 
 #endif // SERVICEMODEL_H
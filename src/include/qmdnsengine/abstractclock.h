@@ -0,0 +1,85 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_ABSTRACTCLOCK_H
+#define QMDNSENGINE_ABSTRACTCLOCK_H
+
+#include <functional>
+
+#include <QObject>
+
+#include "qmdnsengine_export.h"
+
+namespace QMdnsEngine
+{
+
+/**
+ * @brief Base class for sources of time
+ *
+ * Timing within the library (timers as well as record expiry) normally uses
+ * the system clock. A clock derived from this class can be provided instead
+ * through AbstractServer::setClock() and Cache::setClock(), which allows time
+ * to be controlled by the application - see
+ * [ManualClock](@ref QMdnsEngine::ManualClock).
+ */
+class QMDNSENGINE_EXPORT AbstractClock : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * @brief Function invoked when a scheduled time is reached
+     */
+    typedef std::function<void()> Callback;
+
+    /**
+     * @brief Abstract constructor
+     */
+    explicit AbstractClock(QObject *parent = 0);
+
+    /**
+     * @brief Retrieve the current time in milliseconds
+     *
+     * The value must never decrease; its starting point is unimportant.
+     */
+    virtual qint64 elapsed() const = 0;
+
+    /**
+     * @brief Invoke a function once the specified time has passed
+     * @param msec time from now in milliseconds
+     * @param callback function to invoke
+     * @return nonzero identifier that can be passed to cancel()
+     */
+    virtual int schedule(qint64 msec, const Callback &callback) = 0;
+
+    /**
+     * @brief Cancel a function scheduled with schedule()
+     */
+    virtual void cancel(int id) = 0;
+};
+
+}
+
+#endif // QMDNSENGINE_ABSTRACTCLOCK_H
@@ -25,6 +25,12 @@
 #ifndef QMDNSENGINE_ABSTRACTSERVER_H
 #define QMDNSENGINE_ABSTRACTSERVER_H
 
+#include <functional>
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QList>
+#include <QNetworkAddressEntry>
 #include <QObject>
 
 #include "qmdnsengine_export.h"
@@ -32,7 +38,12 @@
 namespace QMdnsEngine
 {
 
+class AbstractClock;
+class Histogram;
 class Message;
+class PreparedMessage;
+
+class QMDNSENGINE_EXPORT AbstractServerPrivate;
 
 /**
  * @brief Base class for sending and receiving DNS messages
@@ -41,6 +52,25 @@ class Message;
  * receive DNS messages. By having them use this base class, they become far
  * easier to test. Any class derived from this one that implements the pure
  * virtual methods can be used for sending and receiving DNS messages.
+ *
+ * Rather than examining every message emitted by messageReceived(), objects
+ * can subscribe to the names and types they are interested in. Each message
+ * is then matched against an index of the subscriptions and only the
+ * matching queries and records are passed to the handler of each subscriber:
+ *
+ * @code
+ * server->setMessageHandler(this, [this](const QMdnsEngine::Message &message) {
+ *     // ...
+ * });
+ * server->subscribe(this, "myhost.local.", QMdnsEngine::A);
+ * @endcode
+ *
+ * The handler is removed along with all of its subscriptions when the
+ * receiver is destroyed.
+ *
+ * Objects using the server also record how long discovery takes. The
+ * latencies are collected in histograms that can be retrieved with
+ * latency() and responseLatency().
  */
 class QMDNSENGINE_EXPORT AbstractServer : public QObject
 {
@@ -48,11 +78,122 @@ class QMDNSENGINE_EXPORT AbstractServer : public QObject
 
 public:
 
+    /**
+     * @brief Latency measured by objects using the server
+     */
+    enum Latency {
+        /// Time from the creation of a Resolver until it resolves an address
+        ResolveLatency,
+        /// Time from the first PTR record for a service until its SRV, TXT,
+        /// and address records have been received
+        DiscoveryLatency,
+        /// Time from a query sent by a Browser until a responder answers it
+        ResponseLatency
+    };
+
     /**
      * @brief Abstract constructor
      */
     explicit AbstractServer(QObject *parent = 0);
 
+    /**
+     * @brief Function invoked with the matching parts of a message
+     */
+    typedef std::function<void(const Message &message)> Handler;
+
+    /**
+     * @brief Set the function that receives messages for a subscriber
+     * @param receiver object that owns the subscriptions
+     * @param handler function to invoke
+     *
+     * The message passed to the handler has the same header and address as
+     * the one received but contains only the queries and records that match
+     * the subscriptions of the receiver. The handler is invoked at most once
+     * per message.
+     */
+    void setMessageHandler(QObject *receiver, const Handler &handler);
+
+    /**
+     * @brief Subscribe to queries and records with the specified name
+     * @param receiver object that owns the subscription
+     * @param name fully qualified name to match
+     * @param type type to match or ANY for all types
+     *
+     * Address records for the target of a matching SRV record are included
+     * as well, since they normally accompany it in the same message.
+     */
+    void subscribe(QObject *receiver, const QByteArray &name, quint16 type);
+
+    /**
+     * @brief Subscribe to queries and records with names in a domain
+     * @param receiver object that owns the subscription
+     * @param suffix domain to match (such as a service type) or an empty
+     *        string for all names
+     * @param type type to match or ANY for all types
+     *
+     * A name matches if it consists of one or more labels followed by the
+     * suffix.
+     */
+    void subscribeSuffix(QObject *receiver, const QByteArray &suffix, quint16 type);
+
+    /**
+     * @brief Remove a subscription created with subscribe()
+     */
+    void unsubscribe(QObject *receiver, const QByteArray &name, quint16 type);
+
+    /**
+     * @brief Remove a subscription created with subscribeSuffix()
+     */
+    void unsubscribeSuffix(QObject *receiver, const QByteArray &suffix, quint16 type);
+
+    /**
+     * @brief Remove the handler and all subscriptions for a receiver
+     */
+    void unsubscribeAll(QObject *receiver);
+
+    /**
+     * @brief Set the clock used for timing by objects using the server
+     * @param clock clock to use or nullptr for the system clock
+     *
+     * Objects pick up the clock when they are created, so it should be set
+     * before creating them.
+     */
+    void setClock(AbstractClock *clock);
+
+    /**
+     * @brief Retrieve the clock set with setClock()
+     * @return clock or nullptr if the system clock is used
+     */
+    AbstractClock *clock() const;
+
+    /**
+     * @brief Record a latency measurement
+     * @param latency kind of latency measured
+     * @param msec latency in milliseconds
+     * @param responder address of the responder for ResponseLatency
+     */
+    void recordLatency(Latency latency, qint64 msec, const QHostAddress &responder = QHostAddress());
+
+    /**
+     * @brief Retrieve the latencies recorded for all responders
+     */
+    Histogram latency(Latency latency) const;
+
+    /**
+     * @brief Retrieve the response latencies recorded for a single responder
+     *
+     * Latencies are kept for the 256 responders that answered most
+     * recently; an empty histogram is returned for any other responder.
+     */
+    Histogram responseLatency(const QHostAddress &responder) const;
+
+    /**
+     * @brief Retrieve the addresses of responders with recorded latencies
+     *
+     * At most 256 responders are listed, those that answered most recently.
+     */
+    QList<QHostAddress> responders() const;
+
     /**
      * @brief Send a message to its provided destination
      *
@@ -68,6 +209,40 @@ public:
      */
     virtual void sendMessageToAll(const Message &message) = 0;
 
+    /**
+     * @brief Send a message that was serialized in advance
+     *
+     * The default implementation passes the message to sendMessage().
+     * Derived classes can override this to send the packet as it is.
+     */
+    virtual void sendPreparedMessage(const PreparedMessage &message);
+
+    /**
+     * @brief Send a message that was serialized in advance to all interfaces
+     *
+     * The default implementation passes the message to sendMessageToAll().
+     */
+    virtual void sendPreparedMessageToAll(const PreparedMessage &message);
+
+    /**
+     * @brief Retrieve the addresses assigned to a network interface
+     * @param interfaceIndex index of the interface
+     *
+     * The default implementation asks the system every time it is called.
+     * Derived classes that keep track of the interfaces can override this to
+     * return the addresses found the last time the interfaces changed.
+     */
+    virtual QList<QNetworkAddressEntry> addressEntries(int interfaceIndex) const;
+
+    /**
+     * @brief Retrieve the indices of the interfaces used for multicast
+     *
+     * The default implementation asks the system for the running interfaces
+     * that support multicast every time it is called. An empty list means
+     * that messages can't be directed to a particular interface.
+     */
+    virtual QList<int> interfaceIndices() const;
+
 Q_SIGNALS:
 
     /**
@@ -76,11 +251,24 @@ Q_SIGNALS:
      */
     void messageReceived(const Message &message);
 
+    /**
+     * @brief Indicate that the network interfaces have changed
+     *
+     * This signal is emitted when an interface is added or removed or when
+     * the addresses assigned to an interface change. Records should be
+     * announced again when this occurs.
+     */
+    void interfacesChanged();
+
     /**
      * @brief Indicate that an error has occurred
      * @param message brief description of the error
      */
     void error(const QString &message);
+
+private:
+
+    AbstractServerPrivate *const d;
 };
 
 }
@@ -26,8 +26,11 @@
 #define QMDNSENGINE_BROWSER_H
 
 #include <QByteArray>
+#include <QList>
 #include <QObject>
 
+#include <qmdnsengine/service.h>
+
 #include "qmdnsengine_export.h"
 
 namespace QMdnsEngine
@@ -35,7 +38,7 @@ namespace QMdnsEngine
 
 class AbstractServer;
 class Cache;
-class Service;
+class Statistics;
 
 class QMDNSENGINE_EXPORT BrowserPrivate;
 
@@ -58,6 +61,16 @@ class QMDNSENGINE_EXPORT BrowserPrivate;
  * QMdnsEngine::Browser browser(&server, "_http._tcp.local.");
  * @endcode
  *
+ * To browse for services of several types, with the questions for all of
+ * them sent in the same message:
+ *
+ * @code
+ * QMdnsEngine::Browser browser(&server, {"_http._tcp.local.", "_ssh._tcp.local."});
+ * @endcode
+ *
+ * The type of each service reported by the signals can be retrieved with
+ * Service::type().
+ *
  * When a service is found, the serviceAdded() signal is emitted:
  *
  * @code
@@ -68,6 +81,14 @@ class QMDNSENGINE_EXPORT BrowserPrivate;
  *
  * The serviceUpdated() and serviceRemoved() signals are emitted when services
  * are updated (their properties change) or are removed, respectively.
+ *
+ * Browsers for the same type that use the same server and cache share their
+ * queries and records, so opening several of them costs no more network
+ * traffic than opening one. Queries for different types that are due at
+ * about the same time are sent together in one message. Browsers created
+ * without a cache share one owned by the server. A browser created while
+ * others are already browsing for its type emits serviceAdded() for the
+ * services they found once control returns to the event loop.
  */
 class QMDNSENGINE_EXPORT Browser : public QObject
 {
@@ -75,6 +96,16 @@ class QMDNSENGINE_EXPORT Browser : public QObject
 
 public:
 
+    /**
+     * @brief Whether a browser sends queries
+     */
+    enum Mode {
+        /// Send queries for services and refresh records before they expire
+        Active,
+        /// Never transmit; rely on announcements and responses to other hosts
+        Passive
+    };
+
     /**
      * @brief Create a new browser instance
      * @param server server to use for receiving and sending mDNS messages
@@ -84,6 +115,118 @@ public:
      */
     Browser(AbstractServer *server, const QByteArray &type, Cache *cache = 0, QObject *parent = 0);
 
+    /**
+     * @brief Create a new browser instance in the specified mode
+     * @param server server to use for receiving and sending mDNS messages
+     * @param type service type to browse for
+     * @param mode whether to send queries
+     * @param cache DNS cache to use or null to create one
+     * @param parent QObject
+     *
+     * A passive browser builds its list of services only from unsolicited
+     * announcements and from responses to queries sent by other hosts. It
+     * never sends a packet of its own, which suits nodes that only monitor
+     * the network. Queries are still sent if an active browser for the same
+     * type shares the server.
+     */
+    Browser(AbstractServer *server, const QByteArray &type, Mode mode, Cache *cache = 0, QObject *parent = 0);
+
+    /**
+     * @brief Create a new browser instance for several service types
+     * @param server server to use for receiving and sending mDNS messages
+     * @param types service types to browse for
+     * @param cache DNS cache to use or null to create one
+     * @param parent QObject
+     */
+    Browser(AbstractServer *server, const QList<QByteArray> &types, Cache *cache = 0, QObject *parent = 0);
+
+    /**
+     * @brief Create a new browser instance for several service types in the
+     * specified mode
+     * @param server server to use for receiving and sending mDNS messages
+     * @param types service types to browse for
+     * @param mode whether to send queries
+     * @param cache DNS cache to use or null to create one
+     * @param parent QObject
+     */
+    Browser(AbstractServer *server, const QList<QByteArray> &types, Mode mode, Cache *cache = 0, QObject *parent = 0);
+
+    /**
+     * @brief Retrieve the service types being browsed for
+     */
+    QList<QByteArray> types() const;
+
+    /**
+     * @brief Retrieve whether the browser sends queries
+     */
+    Mode mode() const;
+
+    /**
+     * @brief Retrieve the services currently known to the browser
+     *
+     * The list holds the services reported by serviceAdded() that have not
+     * been removed since, as last reported. A model can fill itself from
+     * this list and then follow the signals.
+     */
+    QList<Service> services() const;
+
+    /**
+     * @brief Wait for the addresses of services before reporting them
+     * @param resolve true to wait for addresses
+     * @param timeout time to wait in milliseconds before reporting a
+     *        service without addresses
+     *
+     * Services always include the addresses that have been received for
+     * their hosts (see Service::addresses()). When this option is enabled,
+     * the browser also queries for missing addresses, delays serviceAdded()
+     * until at least one address is known (or the timeout passes), and emits
+     * serviceUpdated() when the addresses change. This saves a separate
+     * Resolver for each service.
+     */
+    void setResolveAddresses(bool resolve, int timeout = 2000);
+
+    /**
+     * @brief Set the bounds on the interval between queries
+     * @param minimum interval after the first query in milliseconds
+     * @param maximum longest interval in milliseconds
+     *
+     * The first query is sent immediately. The interval then starts at the
+     * minimum and doubles after each query until it reaches the maximum. It
+     * returns to the minimum when a service is added or removed and when
+     * the network interfaces change. The defaults of one second and one
+     * hour follow RFC 6762.
+     *
+     * Browsers for the same type share their queries, which are sent using
+     * the smallest minimum and the smallest maximum among the active
+     * browsers, so no browser is queried for less often than it asked.
+     * The bounds of passive browsers are ignored.
+     */
+    void setQueryInterval(int minimum, int maximum);
+
+    /**
+     * @brief Retrieve the counters maintained by the browser
+     *
+     * The counters cover the services added, updated, and removed as
+     * reported by this browser. The traffic that it shares with other
+     * browsers is counted by sharedStatistics().
+     */
+    Statistics statistics() const;
+
+    /**
+     * @brief Retrieve the counters shared by the browsers using a server
+     * @param server server used by the browsers
+     * @param cache DNS cache used by the browsers or null if they created
+     * their own
+     *
+     * Browsers that use the same server and cache share their queries and
+     * the responses they receive, so these are counted once for all of
+     * them: responses received, queries sent, queries refreshing records
+     * that are about to expire, and known answers left out of queries for
+     * lack of space. The counters start again from zero once all of the
+     * browsers have been destroyed.
+     */
+    static Statistics sharedStatistics(AbstractServer *server, Cache *cache = 0);
+
 Q_SIGNALS:
 
     /**
@@ -112,6 +255,32 @@ Q_SIGNALS:
      */
     void serviceRemoved(const Service &service);
 
+    /**
+     * @brief Indicate that services were added
+     *
+     * The batch signals report the net changes from a single message (or
+     * expired record) at once, after the individual signals for them. A
+     * service appears in at most one of the lists, and the batches are
+     * emitted in the order servicesRemoved(), servicesAdded(), and
+     * servicesUpdated(), which lets a model insert all of the new rows with
+     * a single beginInsertRows().
+     */
+    void servicesAdded(const QList<Service> &services);
+
+    /**
+     * @brief Indicate that services were updated
+     *
+     * See servicesAdded() for how changes are batched.
+     */
+    void servicesUpdated(const QList<Service> &services);
+
+    /**
+     * @brief Indicate that services were removed
+     *
+     * See servicesAdded() for how changes are batched.
+     */
+    void servicesRemoved(const QList<Service> &services);
+
 private:
 
     BrowserPrivate *const d;
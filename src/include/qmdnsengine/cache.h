@@ -33,7 +33,9 @@
 namespace QMdnsEngine
 {
 
+class AbstractClock;
 class Record;
+class Statistics;
 
 class QMDNSENGINE_EXPORT CachePrivate;
 
@@ -73,6 +75,14 @@ public:
      */
     explicit Cache(QObject *parent = 0);
 
+    /**
+     * @brief Set the clock used for record expiry
+     * @param clock clock to use or nullptr for the system clock
+     *
+     * The clock should be set before any records are added.
+     */
+    void setClock(AbstractClock *clock);
+
     /**
      * @brief Add a record to the cache
      * @param record add this record to the cache
@@ -105,6 +115,29 @@ public:
      */
     bool lookupRecords(const QByteArray &name, quint16 type, QList<Record> &records) const;
 
+    /**
+     * @brief Retrieve multiple records along with their remaining lifetime
+     * @param name name of records to retrieve or null for any
+     * @param type type of records to retrieve or ANY for all types
+     * @param records storage for the records retrieved
+     * @param remaining storage for the time (in milliseconds) until each of
+     * the retrieved records expires
+     * @return true if records were retrieved
+     *
+     * The records keep the TTL they were added with, so comparing it with
+     * the remaining time shows how much of each record's lifetime is left.
+     */
+    bool lookupRecords(const QByteArray &name, quint16 type, QList<Record> &records,
+                       QList<qint64> &remaining) const;
+
+    /**
+     * @brief Retrieve the counters maintained by the cache
+     *
+     * The counters cover lookups that found or did not find records, records
+     * added and expired, and requests to refresh records about to expire.
+     */
+    Statistics statistics() const;
+
 Q_SIGNALS:
 
     /**
@@ -0,0 +1,170 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_EPOLLSERVER_H
+#define QMDNSENGINE_EPOLLSERVER_H
+
+#include <qmdnsengine/abstractserver.h>
+
+#include "qmdnsengine_export.h"
+
+namespace QMdnsEngine
+{
+
+class Message;
+class Statistics;
+
+class QMDNSENGINE_EXPORT EpollServerPrivate;
+
+/**
+ * @brief mDNS server using native sockets and epoll
+ *
+ * This class provides an implementation of
+ * [AbstractServer](@ref QMdnsEngine::AbstractServer) for Linux that works
+ * directly with UDP sockets and an epoll instance instead of QUdpSocket. It
+ * is only available when the library is built with the BUILD_EPOLL_SERVER
+ * option, in which case QMDNSENGINE_EPOLL_SERVER is defined.
+ *
+ * Messages are encoded and decoded exactly as they are for
+ * [Server](@ref QMdnsEngine::Server), and changes to the network interfaces
+ * are tracked the same way. Datagrams are read and written in batches and
+ * every socket (including those used for tracking interfaces) is waited on
+ * with a single epoll instance.
+ *
+ * By default, the epoll instance is watched by the Qt event loop of the
+ * thread that created the server. A program that runs its own loop can
+ * instead poll descriptor() itself and call processEvents() when it becomes
+ * readable, or simply call processEvents() with a timeout:
+ *
+ * @code
+ * QMdnsEngine::EpollServer server(QMdnsEngine::EpollServer::ManualDispatch);
+ * forever {
+ *     server.processEvents(-1);
+ * }
+ * @endcode
+ *
+ * messageReceived() is emitted from within processEvents(). Records in
+ * multicast responses are limited to one multicast per second exactly as
+ * they are by Server, but unlike Server, outgoing messages are not
+ * coalesced.
+ */
+class QMDNSENGINE_EXPORT EpollServer : public AbstractServer
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * @brief Method used to wait for network activity
+     */
+    enum DispatchMode {
+        /// Process events from the Qt event loop of the current thread
+        EventLoopDispatch,
+        /// Only process events when processEvents() is called
+        ManualDispatch
+    };
+
+    /**
+     * @brief Create a new server
+     */
+    explicit EpollServer(QObject *parent = 0);
+
+    /**
+     * @brief Create a new server using the specified dispatch mode
+     * @param mode method used to wait for network activity
+     * @param parent QObject
+     */
+    explicit EpollServer(DispatchMode mode, QObject *parent = 0);
+
+    /**
+     * @brief Destroy the server
+     */
+    virtual ~EpollServer();
+
+    /**
+     * @brief Retrieve the epoll file descriptor
+     *
+     * The descriptor becomes readable when processEvents() has work to do.
+     */
+    int descriptor() const;
+
+    /**
+     * @brief Wait for and process network activity
+     * @param msec time to wait in milliseconds, 0 to return immediately, or
+     *        -1 to wait indefinitely
+     * @return number of events processed or -1 if an error occurred
+     */
+    int processEvents(int msec = 0);
+
+    /**
+     * @brief Retrieve the counters maintained by the server
+     *
+     * These are the same as the counters of Server::statistics(), except
+     * for the number of messages coalesced.
+     */
+    Statistics statistics() const;
+
+    /**
+     * @brief Implementation of AbstractServer::sendMessage()
+     */
+    virtual void sendMessage(const Message &message);
+
+    /**
+     * @brief Implementation of AbstractServer::sendMessageToAll()
+     */
+    virtual void sendMessageToAll(const Message &message);
+
+    /**
+     * @brief Implementation of AbstractServer::sendPreparedMessage()
+     */
+    virtual void sendPreparedMessage(const PreparedMessage &message);
+
+    /**
+     * @brief Implementation of AbstractServer::sendPreparedMessageToAll()
+     */
+    virtual void sendPreparedMessageToAll(const PreparedMessage &message);
+
+    /**
+     * @brief Implementation of AbstractServer::addressEntries()
+     *
+     * The addresses are kept from the last time the interfaces were
+     * enumerated, so looking them up does not enumerate them again.
+     */
+    virtual QList<QNetworkAddressEntry> addressEntries(int interfaceIndex) const;
+
+    /**
+     * @brief Implementation of AbstractServer::interfaceIndices()
+     *
+     * These are the interfaces that multicast messages are sent out of.
+     */
+    virtual QList<int> interfaceIndices() const;
+
+private:
+
+    EpollServerPrivate *const d;
+};
+
+}
+
+#endif // QMDNSENGINE_EPOLLSERVER_H
@@ -0,0 +1,139 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_HISTOGRAM_H
+#define QMDNSENGINE_HISTOGRAM_H
+
+#include <QByteArray>
+
+#include "qmdnsengine_export.h"
+
+namespace QMdnsEngine
+{
+
+class QMDNSENGINE_EXPORT HistogramPrivate;
+
+/**
+ * @brief Distribution of recorded values, such as latencies
+ *
+ * Values are counted in buckets that grow with the magnitude of the value so
+ * that any value up to several years in milliseconds can be recorded with a
+ * relative error of less than 2% while using little memory. Values below 128
+ * are recorded exactly.
+ *
+ * The latencies collected by an AbstractServer are provided as instances of
+ * this class:
+ *
+ * @code
+ * QMdnsEngine::Histogram histogram = server.latency(QMdnsEngine::AbstractServer::DiscoveryLatency);
+ * qDebug() << histogram.percentile(99) << "ms";
+ * @endcode
+ */
+class QMDNSENGINE_EXPORT Histogram
+{
+public:
+
+    /**
+     * @brief Create an empty histogram
+     */
+    Histogram();
+
+    /**
+     * @brief Create a copy of an existing histogram
+     */
+    Histogram(const Histogram &other);
+
+    /**
+     * @brief Assignment operator
+     */
+    Histogram &operator=(const Histogram &other);
+
+    /**
+     * @brief Destroy the histogram
+     */
+    virtual ~Histogram();
+
+    /**
+     * @brief Record a value
+     *
+     * Negative values are recorded as 0.
+     */
+    void record(qint64 value);
+
+    /**
+     * @brief Retrieve the number of values recorded
+     */
+    quint64 count() const;
+
+    /**
+     * @brief Retrieve the smallest value recorded or 0 if there are none
+     */
+    qint64 minimum() const;
+
+    /**
+     * @brief Retrieve the largest value recorded or 0 if there are none
+     */
+    qint64 maximum() const;
+
+    /**
+     * @brief Retrieve the sum of the values recorded
+     */
+    qint64 sum() const;
+
+    /**
+     * @brief Retrieve the mean of the values recorded or 0 if there are none
+     */
+    double mean() const;
+
+    /**
+     * @brief Retrieve the value below which a percentage of values fall
+     * @param percentile percentage between 0 and 100
+     *
+     * The value returned is the largest value in the bucket containing the
+     * percentile (or the maximum, if smaller).
+     */
+    qint64 percentile(double percentile) const;
+
+    /**
+     * @brief Add the values from another histogram to this one
+     */
+    Histogram &operator+=(const Histogram &other);
+
+    /**
+     * @brief Write the histogram in the Prometheus text exposition format
+     * @param name name of the metric
+     *
+     * The histogram is written as a summary with the median and the 90th,
+     * 99th, and 99.9th percentiles.
+     */
+    QByteArray toPrometheus(const QByteArray &name) const;
+
+private:
+
+    HistogramPrivate *const d;
+};
+
+}
+
+#endif // QMDNSENGINE_HISTOGRAM_H
@@ -43,6 +43,10 @@ class QMDNSENGINE_EXPORT HostnamePrivate;
  * be used. This class asserts a hostname (by first confirming that it is not
  * in use) and then responds to A and AAAA queries for the hostname.
  *
+ * When the network interfaces change, the hostname is announced again on
+ * the links that were already present. Links that were added are probed
+ * first, and the hostname is only given up if another host there uses it.
+ *
  * @code
  * QMdnsEngine::Hostname hostname(&server);
  *
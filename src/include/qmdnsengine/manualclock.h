@@ -0,0 +1,103 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_MANUALCLOCK_H
+#define QMDNSENGINE_MANUALCLOCK_H
+
+#include <qmdnsengine/abstractclock.h>
+
+#include "qmdnsengine_export.h"
+
+namespace QMdnsEngine
+{
+
+class QMDNSENGINE_EXPORT ManualClockPrivate;
+
+/**
+ * @brief %Clock that only moves forward when instructed to
+ *
+ * Time stands still until advance() is called, at which point everything
+ * scheduled up to the new time is run in order. This makes it possible to
+ * test timing-dependent behavior (such as probing or record expiry) without
+ * waiting and to simulate hours of activity in a moment:
+ *
+ * @code
+ * QMdnsEngine::ManualClock clock;
+ * server.setClock(&clock);
+ *
+ * QMdnsEngine::Hostname hostname(&server);
+ * clock.advance(5 * 1000);
+ * @endcode
+ */
+class QMDNSENGINE_EXPORT ManualClock : public AbstractClock
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * @brief Create a new clock starting at zero
+     */
+    explicit ManualClock(QObject *parent = 0);
+
+    /**
+     * @brief Implementation of AbstractClock::elapsed()
+     */
+    virtual qint64 elapsed() const;
+
+    /**
+     * @brief Implementation of AbstractClock::schedule()
+     */
+    virtual int schedule(qint64 msec, const Callback &callback);
+
+    /**
+     * @brief Implementation of AbstractClock::cancel()
+     */
+    virtual void cancel(int id);
+
+    /**
+     * @brief Move the clock forward
+     * @param msec time in milliseconds
+     * @return number of scheduled functions that were invoked
+     *
+     * Functions are invoked in the order they are due, with the clock set to
+     * the time each one was scheduled for. Anything they schedule that falls
+     * within the interval is invoked as well.
+     */
+    int advance(qint64 msec);
+
+    /**
+     * @brief Retrieve the time until the next scheduled function is due
+     * @return time in milliseconds or -1 if nothing is scheduled
+     */
+    qint64 remainingTime() const;
+
+private:
+
+    ManualClockPrivate *const d;
+};
+
+}
+
+#endif // QMDNSENGINE_MANUALCLOCK_H
@@ -116,6 +116,23 @@ public:
      */
     void setPort(quint16 port);
 
+    /**
+     * @brief Retrieve the index of the network interface for the message
+     *
+     * When receiving messages, this is the index of the interface that the
+     * message was received on or 0 if it is not known.
+     */
+    int interfaceIndex() const;
+
+    /**
+     * @brief Set the index of the network interface for the message
+     *
+     * When sending messages, a nonzero index restricts the message to the
+     * interface with that index. The default is 0, which lets the server
+     * choose the interface.
+     */
+    void setInterfaceIndex(int interfaceIndex);
+
     /**
      * @brief Retrieve the transaction ID for the message
      *
@@ -172,12 +189,31 @@ public:
      */
     void addRecord(const Record &record);
 
+    /**
+     * @brief Retrieve the number of records in the authority section
+     *
+     * The list returned by records() holds the answer records, followed by
+     * those in the authority section and then any additional records. Probes
+     * (RFC 6762 section 8.2) carry the proposed records in the authority
+     * section.
+     */
+    int authorityCount() const;
+
+    /**
+     * @brief Set the number of records in the authority section
+     *
+     * When sending messages, this many records at the end of the list are
+     * written to the authority section. The default is 0, which writes all
+     * of them as answers.
+     */
+    void setAuthorityCount(int authorityCount);
+
     /**
      * @brief Reply to another message
      *
      * The message will be correctly initialized to respond to the other
-     * message. This includes setting the target address, port, and
-     * transaction ID.
+     * message. This includes setting the target address, port, interface,
+     * and transaction ID.
      */
     void reply(const Message &other);
 
@@ -0,0 +1,126 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_PREPAREDMESSAGE_H
+#define QMDNSENGINE_PREPAREDMESSAGE_H
+
+#include <QByteArray>
+#include <QHostAddress>
+
+#include "qmdnsengine_export.h"
+
+namespace QMdnsEngine
+{
+
+class Message;
+
+class QMDNSENGINE_EXPORT PreparedMessagePrivate;
+
+/**
+ * @brief DNS message that has already been serialized
+ *
+ * Serializing a message with toPacket() has a cost. A message that is sent
+ * repeatedly (an announcement, for example) can instead be serialized once
+ * and sent as many times as needed with
+ * [AbstractServer::sendPreparedMessage()](@ref QMdnsEngine::AbstractServer::sendPreparedMessage)
+ * or AbstractServer::sendPreparedMessageToAll().
+ *
+ * The destination is not part of the packet and can be changed without
+ * serializing the message again:
+ *
+ * @code
+ * QMdnsEngine::PreparedMessage prepared(message);
+ * prepared.setAddress(QMdnsEngine::MdnsIpv4Address);
+ * server.sendPreparedMessage(prepared);
+ * @endcode
+ */
+class QMDNSENGINE_EXPORT PreparedMessage
+{
+public:
+
+    /**
+     * @brief Create a null prepared message
+     */
+    PreparedMessage();
+
+    /**
+     * @brief Serialize a message
+     */
+    explicit PreparedMessage(const Message &message);
+
+    /**
+     * @brief Create a copy of an existing prepared message
+     *
+     * The packet data is shared rather than copied.
+     */
+    PreparedMessage(const PreparedMessage &other);
+
+    /**
+     * @brief Assignment operator
+     */
+    PreparedMessage &operator=(const PreparedMessage &other);
+
+    /**
+     * @brief Destroy the prepared message
+     */
+    virtual ~PreparedMessage();
+
+    /**
+     * @brief Determine if a message was serialized
+     */
+    bool isNull() const;
+
+    /**
+     * @brief Retrieve the message (including its destination)
+     */
+    Message message() const;
+
+    /**
+     * @brief Retrieve the serialized message
+     */
+    QByteArray packet() const;
+
+    /**
+     * @brief Set the address the message will be sent to
+     */
+    void setAddress(const QHostAddress &address);
+
+    /**
+     * @brief Set the port the message will be sent to
+     */
+    void setPort(quint16 port);
+
+    /**
+     * @brief Set the index of the interface the message will be sent from
+     */
+    void setInterfaceIndex(int interfaceIndex);
+
+private:
+
+    PreparedMessagePrivate *const d;
+};
+
+}
+
+#endif // QMDNSENGINE_PREPAREDMESSAGE_H
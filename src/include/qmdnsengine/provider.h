@@ -35,6 +35,7 @@ namespace QMdnsEngine
 class AbstractServer;
 class Hostname;
 class Service;
+class Statistics;
 
 class QMDNSENGINE_EXPORT ProviderPrivate;
 
@@ -80,6 +81,15 @@ public:
      */
     void update(const Service &service);
 
+    /**
+     * @brief Retrieve the counters maintained by the provider
+     *
+     * The counters cover queries received, replies sent, records left out of
+     * replies because another responder sent them first, announcements, and
+     * probes along with the number of them that found the name in use.
+     */
+    Statistics statistics() const;
+
 private:
 
     ProviderPrivate *const d;
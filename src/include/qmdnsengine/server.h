@@ -33,6 +33,7 @@ namespace QMdnsEngine
 {
 
 class Message;
+class Statistics;
 
 class QMDNSENGINE_EXPORT ServerPrivate;
 
@@ -46,6 +47,24 @@ class QMDNSENGINE_EXPORT ServerPrivate;
  * The class takes care of watching for the addition and removal of network
  * interfaces, automatically joining multicast groups when new interfaces are
  * available.
+ *
+ * Received messages carry the index of the interface they arrived on (see
+ * Message::interfaceIndex()). Messages sent with sendMessageToAll() go out of
+ * every interface unless they are restricted to one.
+ *
+ * By default, the sockets are serviced by the event loop of the thread that
+ * created the server. To keep heavy mDNS traffic off of that event loop, the
+ * server can instead be given a thread of its own for reading, parsing, and
+ * writing messages:
+ *
+ * @code
+ * QMdnsEngine::Server server(QMdnsEngine::Server::DedicatedThread);
+ * @endcode
+ *
+ * Parsed messages are then handed back to the thread that created the server
+ * and messageReceived() is emitted there, so the rest of the library is used
+ * in exactly the same way. error() and interfacesChanged() are emitted on
+ * that thread as well.
  */
 class QMDNSENGINE_EXPORT Server : public AbstractServer
 {
@@ -53,11 +72,35 @@ class QMDNSENGINE_EXPORT Server : public AbstractServer
 
 public:
 
+    /**
+     * @brief Thread used for network I/O
+     */
+    enum ThreadMode {
+        /// Use the thread that created the server
+        CurrentThread,
+        /// Start a separate thread owned by the server
+        DedicatedThread
+    };
+
     /**
      * @brief Create a new server
      */
     explicit Server(QObject *parent = 0);
 
+    /**
+     * @brief Create a new server that performs I/O on the specified thread
+     * @param mode thread used for network I/O
+     * @param parent QObject
+     */
+    explicit Server(ThreadMode mode, QObject *parent = 0);
+
+    /**
+     * @brief Destroy the server
+     *
+     * If the server has its own thread, it is stopped.
+     */
+    virtual ~Server();
+
     /**
      * @brief Implementation of AbstractServer::sendMessage()
      */
@@ -68,6 +111,74 @@ public:
      */
     virtual void sendMessageToAll(const Message &message);
 
+    /**
+     * @brief Implementation of AbstractServer::sendPreparedMessage()
+     */
+    virtual void sendPreparedMessage(const PreparedMessage &message);
+
+    /**
+     * @brief Implementation of AbstractServer::sendPreparedMessageToAll()
+     */
+    virtual void sendPreparedMessageToAll(const PreparedMessage &message);
+
+    /**
+     * @brief Implementation of AbstractServer::addressEntries()
+     *
+     * The addresses are kept from the last time the interfaces were
+     * enumerated, so looking them up does not enumerate them again.
+     */
+    virtual QList<QNetworkAddressEntry> addressEntries(int interfaceIndex) const;
+
+    /**
+     * @brief Implementation of AbstractServer::interfaceIndices()
+     *
+     * These are the interfaces that multicast messages are sent out of. The
+     * list is empty if the server can't choose the interface that a message
+     * is sent out of (with Qt versions before 5.8, except on Linux).
+     */
+    virtual QList<int> interfaceIndices() const;
+
+    /**
+     * @brief Set the time spent gathering outgoing multicast responses
+     * @param msec interval in milliseconds (up to 120) or 0 to disable
+     *
+     * Responses with shared records sent to the multicast groups within the
+     * interval are merged into as few packets as possible and duplicate
+     * records are removed. RFC 6762 permits delays of 20-120 ms for these;
+     * the default is 20 ms. Queries and responses that only contain unique
+     * records are always sent immediately.
+     */
+    void setCoalescingInterval(int msec);
+
+    /**
+     * @brief Retrieve the number of records left out of multicast responses
+     *
+     * RFC 6762 section 6 forbids multicasting a record on an interface more
+     * than once per second, except in response to a probe. Records in a
+     * multicast response that were multicast less than a second earlier on
+     * every interface the response is sent on are removed before the
+     * response is sent, unless a probe for their name was received in the
+     * meantime.
+     */
+    quint64 suppressedRecords() const;
+
+    /**
+     * @brief Retrieve the number of multicast responses not sent at all
+     *
+     * This is the number of responses that were dropped because all of their
+     * records had been multicast less than a second earlier.
+     */
+    quint64 suppressedMessages() const;
+
+    /**
+     * @brief Retrieve the counters maintained by the server
+     *
+     * The counters cover packets and bytes received and sent, packets that
+     * could not be parsed, errors while sending, and messages merged or
+     * records suppressed before sending. They can be read from any thread.
+     */
+    Statistics statistics() const;
+
 private:
 
     ServerPrivate *const d;
@@ -31,6 +31,8 @@
 #include <QMap>
 #include <QDebug>
 
+#include <qmdnsengine/record.h>
+
 #include "qmdnsengine_export.h"
 
 namespace QMdnsEngine
@@ -127,6 +129,44 @@ public:
      */
     void setPort(quint16 port);
 
+    /**
+     * @brief Retrieve the addresses of the hosts providing the service
+     *
+     * Browser fills in the addresses it has received for the targets of the
+     * service. The list may be empty if none have been received yet.
+     */
+    QList<QHostAddress> addresses() const;
+
+    /**
+     * @brief Set the addresses of the hosts providing the service
+     */
+    void setAddresses(const QList<QHostAddress> &addresses);
+
+    /**
+     * @brief Retrieve the SRV records for the service
+     *
+     * A service provided by several hosts has a SRV record for each of them.
+     * The hostname() and port() are those of the record with the lowest
+     * priority (and the highest weight among those).
+     */
+    QList<Record> targets() const;
+
+    /**
+     * @brief Set the SRV records for the service
+     */
+    void setTargets(const QList<Record> &targets);
+
+    /**
+     * @brief Order the SRV records for connecting to the service
+     *
+     * The records are sorted by priority. Records with the same priority
+     * are placed in a random order that favors those with a greater weight,
+     * as described in RFC 2782. Clients should attempt to connect to each
+     * target in turn; picking the first one distributes the load across the
+     * hosts according to their weights.
+     */
+    QList<Record> orderedTargets() const;
+
     /**
      * @brief Retrieve the attributes for the service
      *
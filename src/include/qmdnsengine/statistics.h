@@ -0,0 +1,115 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_STATISTICS_H
+#define QMDNSENGINE_STATISTICS_H
+
+#include <QByteArray>
+#include <QList>
+
+#include "qmdnsengine_export.h"
+
+namespace QMdnsEngine
+{
+
+class QMDNSENGINE_EXPORT StatisticsPrivate;
+
+/**
+ * @brief Snapshot of counters maintained by an object
+ *
+ * Server, Cache, Browser, and Provider each count the work they do (packets
+ * and bytes, cache hits and misses, probes, and so on). The counters are
+ * updated without locking and can be read at any time through the
+ * statistics() method of each object, which returns an instance of this
+ * class:
+ *
+ * @code
+ * QMdnsEngine::Statistics statistics = server.statistics();
+ * qDebug() << statistics.value("packets_received");
+ * @endcode
+ *
+ * Snapshots from several objects can be added together and written in the
+ * Prometheus text format with toPrometheus().
+ */
+class QMDNSENGINE_EXPORT Statistics
+{
+public:
+
+    /**
+     * @brief Create an empty snapshot
+     */
+    Statistics();
+
+    /**
+     * @brief Create a copy of an existing snapshot
+     */
+    Statistics(const Statistics &other);
+
+    /**
+     * @brief Assignment operator
+     */
+    Statistics &operator=(const Statistics &other);
+
+    /**
+     * @brief Destroy the snapshot
+     */
+    virtual ~Statistics();
+
+    /**
+     * @brief Retrieve the names of the counters in the order they were added
+     */
+    QList<QByteArray> names() const;
+
+    /**
+     * @brief Retrieve the value of a counter
+     * @return value or 0 if there is no counter with the name
+     */
+    quint64 value(const QByteArray &name) const;
+
+    /**
+     * @brief Set the value of a counter, adding it if necessary
+     */
+    void setValue(const QByteArray &name, quint64 value);
+
+    /**
+     * @brief Add the counters from another snapshot to this one
+     */
+    Statistics &operator+=(const Statistics &other);
+
+    /**
+     * @brief Write the counters in the Prometheus text exposition format
+     * @param prefix string prepended to the name of each counter
+     *
+     * Each counter becomes a metric named prefix_name_total.
+     */
+    QByteArray toPrometheus(const QByteArray &prefix = "qmdnsengine") const;
+
+private:
+
+    StatisticsPrivate *const d;
+};
+
+}
+
+#endif // QMDNSENGINE_STATISTICS_H
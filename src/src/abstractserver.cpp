@@ -22,11 +22,369 @@
  * IN THE SOFTWARE.
  */
 
+#include <algorithm>
+
+#include <QNetworkInterface>
+
+#include <qmdnsengine/abstractclock.h>
 #include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/histogram.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/preparedmessage.h>
+#include <qmdnsengine/record.h>
+
+#include "abstractserver_p.h"
 
 using namespace QMdnsEngine;
 
+// Response latencies are kept for at most this many responders
+const int MaxResponders = 256;
+
+static int deliveryIndex(QList<AbstractServerPrivate::Delivery> &deliveries,
+                         QHash<QObject*, int> &indices, QObject *receiver)
+{
+    auto i = indices.constFind(receiver);
+    if (i != indices.constEnd()) {
+        return i.value();
+    }
+    AbstractServerPrivate::Delivery delivery;
+    delivery.receiver = receiver;
+    deliveries.append(delivery);
+    indices.insert(receiver, deliveries.count() - 1);
+    return deliveries.count() - 1;
+}
+
+AbstractServerPrivate::AbstractServerPrivate(AbstractServer *server)
+    : QObject(server),
+      responseCount(0)
+{
+    connect(server, &AbstractServer::messageReceived, this, &AbstractServerPrivate::onMessageReceived);
+}
+
+AbstractServerPrivate::Receiver &AbstractServerPrivate::addReceiver(QObject *receiver)
+{
+    auto i = receivers.find(receiver);
+    if (i == receivers.end()) {
+        connect(receiver, &QObject::destroyed, this, &AbstractServerPrivate::onDestroyed);
+        i = receivers.insert(receiver, Receiver());
+    }
+    return i.value();
+}
+
+void AbstractServerPrivate::removeReceiver(QObject *receiver)
+{
+    auto i = receivers.find(receiver);
+    if (i == receivers.end()) {
+        return;
+    }
+    const Receiver entry = i.value();
+    receivers.erase(i);
+    for (const QByteArray &name : entry.names) {
+        QList<Subscription> &subscriptions = names[name];
+        for (auto j = subscriptions.begin(); j != subscriptions.end();) {
+            j = j->receiver == receiver ? subscriptions.erase(j) : j + 1;
+        }
+        if (subscriptions.isEmpty()) {
+            names.remove(name);
+        }
+    }
+    for (const QByteArray &suffix : entry.suffixes) {
+        QList<Subscription> &subscriptions = suffixes[suffix];
+        for (auto j = subscriptions.begin(); j != subscriptions.end();) {
+            j = j->receiver == receiver ? subscriptions.erase(j) : j + 1;
+        }
+        if (subscriptions.isEmpty()) {
+            suffixes.remove(suffix);
+        }
+    }
+}
+
+bool AbstractServerPrivate::addSubscription(QHash<QByteArray, QList<Subscription>> &index,
+                                            QObject *receiver, const QByteArray &key, quint16 type)
+{
+    QList<Subscription> &subscriptions = index[key];
+    for (const Subscription &subscription : subscriptions) {
+        if (subscription.receiver == receiver && subscription.type == type) {
+            return false;
+        }
+    }
+    Subscription subscription = {receiver, type};
+    subscriptions.append(subscription);
+    return true;
+}
+
+bool AbstractServerPrivate::removeSubscription(QHash<QByteArray, QList<Subscription>> &index,
+                                               QObject *receiver, const QByteArray &key, quint16 type)
+{
+    auto i = index.find(key);
+    if (i == index.end()) {
+        return false;
+    }
+    QList<Subscription> &subscriptions = i.value();
+    for (auto j = subscriptions.begin(); j != subscriptions.end(); ++j) {
+        if (j->receiver == receiver && j->type == type) {
+            subscriptions.erase(j);
+            if (subscriptions.isEmpty()) {
+                index.erase(i);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void AbstractServerPrivate::match(const QByteArray &name, quint16 type, QList<QObject*> &matches) const
+{
+    // Look up the name itself and then each of its suffixes (dropping one
+    // label at a time) - the cost depends on the length of the name and the
+    // number of matches rather than the number of subscriptions
+
+    auto i = names.constFind(name);
+    if (i != names.constEnd()) {
+        matchType(i.value(), type, matches);
+    }
+
+    if (suffixes.isEmpty()) {
+        return;
+    }
+    for (int index = name.indexOf('.'); index != -1; index = name.indexOf('.', index + 1)) {
+        auto j = suffixes.constFind(QByteArray::fromRawData(name.constData() + index + 1, name.size() - index - 1));
+        if (j != suffixes.constEnd()) {
+            matchType(j.value(), type, matches);
+        }
+    }
+    if (!name.endsWith('.')) {
+        auto j = suffixes.constFind(QByteArray());
+        if (j != suffixes.constEnd()) {
+            matchType(j.value(), type, matches);
+        }
+    }
+}
+
+void AbstractServerPrivate::matchType(const QList<Subscription> &subscriptions, quint16 type, QList<QObject*> &matches) const
+{
+    for (const Subscription &subscription : subscriptions) {
+        if ((subscription.type == ANY || type == ANY || subscription.type == type) &&
+                !matches.contains(subscription.receiver)) {
+            matches.append(subscription.receiver);
+        }
+    }
+}
+
+void AbstractServerPrivate::onMessageReceived(const Message &message)
+{
+    if (receivers.isEmpty()) {
+        return;
+    }
+
+    // Determine which queries and records each receiver is interested in
+
+    QList<Delivery> deliveries;
+    QHash<QObject*, int> indices;
+    QList<QObject*> matches;
+
+    const auto queries = message.queries();
+    for (const Query &query : queries) {
+        matches.clear();
+        match(query.name(), query.type(), matches);
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
+        for (QObject *receiver : std::as_const(matches)) {
+#else
+        for (QObject *receiver : qAsConst(matches)) {
+#endif
+            deliveries[deliveryIndex(deliveries, indices, receiver)].queries.append(query);
+        }
+    }
+
+    const auto records = message.records();
+    for (int i = 0; i < records.count(); ++i) {
+        const Record &record = records.at(i);
+        matches.clear();
+        match(record.name(), record.type(), matches);
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
+        for (QObject *receiver : std::as_const(matches)) {
+#else
+        for (QObject *receiver : qAsConst(matches)) {
+#endif
+            Delivery &delivery = deliveries[deliveryIndex(deliveries, indices, receiver)];
+            delivery.records.append(i);
+            if (record.type() == SRV) {
+                delivery.targets.insert(record.target());
+            }
+        }
+    }
+
+    // Include the address records for any SRV targets and then hand each
+    // receiver a message with its share of the queries and records (the
+    // handler is copied since it may remove itself)
+
+    for (Delivery &delivery : deliveries) {
+        if (!delivery.targets.isEmpty()) {
+            for (int i = 0; i < records.count(); ++i) {
+                const Record &record = records.at(i);
+                if ((record.type() == A || record.type() == AAAA) &&
+                        delivery.targets.contains(record.name()) &&
+                        !delivery.records.contains(i)) {
+                    delivery.records.append(i);
+                }
+            }
+            std::sort(delivery.records.begin(), delivery.records.end());
+        }
+
+        if (!delivery.receiver) {
+            continue;
+        }
+        auto i = receivers.constFind(delivery.receiver.data());
+        if (i == receivers.constEnd() || !i.value().handler) {
+            continue;
+        }
+        AbstractServer::Handler handler = i.value().handler;
+
+        Message filtered;
+        filtered.setAddress(message.address());
+        filtered.setPort(message.port());
+        filtered.setInterfaceIndex(message.interfaceIndex());
+        filtered.setTransactionId(message.transactionId());
+        filtered.setResponse(message.isResponse());
+        filtered.setTruncated(message.isTruncated());
+        for (const Query &query : delivery.queries) {
+            filtered.addQuery(query);
+        }
+        for (int index : delivery.records) {
+            filtered.addRecord(records.at(index));
+        }
+        handler(filtered);
+    }
+}
+
+void AbstractServerPrivate::onDestroyed(QObject *object)
+{
+    removeReceiver(object);
+}
+
 AbstractServer::AbstractServer(QObject *parent)
-    : QObject(parent)
+    : QObject(parent),
+      d(new AbstractServerPrivate(this))
+{
+}
+
+void AbstractServer::sendPreparedMessage(const PreparedMessage &message)
+{
+    sendMessage(message.message());
+}
+
+void AbstractServer::sendPreparedMessageToAll(const PreparedMessage &message)
+{
+    sendMessageToAll(message.message());
+}
+
+QList<QNetworkAddressEntry> AbstractServer::addressEntries(int interfaceIndex) const
+{
+    return QNetworkInterface::interfaceFromIndex(interfaceIndex).addressEntries();
+}
+
+QList<int> AbstractServer::interfaceIndices() const
+{
+    QList<int> indices;
+    const auto interfaces = QNetworkInterface::allInterfaces();
+    for (const QNetworkInterface &networkInterface : interfaces) {
+        if ((networkInterface.flags() & QNetworkInterface::CanMulticast) &&
+                (networkInterface.flags() & QNetworkInterface::IsRunning)) {
+            indices.append(networkInterface.index());
+        }
+    }
+    return indices;
+}
+
+void AbstractServer::setClock(AbstractClock *clock)
+{
+    d->clock = clock;
+}
+
+AbstractClock *AbstractServer::clock() const
+{
+    return d->clock;
+}
+
+void AbstractServer::recordLatency(Latency latency, qint64 msec, const QHostAddress &responder)
+{
+    d->latencies[latency].record(msec);
+    if (latency != ResponseLatency || responder.isNull()) {
+        return;
+    }
+
+    // Make room for a new responder by forgetting the one that has gone
+    // the longest without answering
+    if (!d->responseLatencies.contains(responder) &&
+            d->responseLatencies.count() >= MaxResponders) {
+        auto oldest = d->responseLatencies.begin();
+        for (auto i = oldest; i != d->responseLatencies.end(); ++i) {
+            if (i.value().lastResponse < oldest.value().lastResponse) {
+                oldest = i;
+            }
+        }
+        d->responseLatencies.erase(oldest);
+    }
+    AbstractServerPrivate::ResponderLatency &entry = d->responseLatencies[responder];
+    entry.histogram.record(msec);
+    entry.lastResponse = ++d->responseCount;
+}
+
+Histogram AbstractServer::latency(Latency latency) const
+{
+    return d->latencies[latency];
+}
+
+Histogram AbstractServer::responseLatency(const QHostAddress &responder) const
+{
+    return d->responseLatencies.value(responder).histogram;
+}
+
+QList<QHostAddress> AbstractServer::responders() const
+{
+    return d->responseLatencies.keys();
+}
+
+void AbstractServer::setMessageHandler(QObject *receiver, const Handler &handler)
+{
+    d->addReceiver(receiver).handler = handler;
+}
+
+void AbstractServer::subscribe(QObject *receiver, const QByteArray &name, quint16 type)
+{
+    AbstractServerPrivate::Receiver &entry = d->addReceiver(receiver);
+    if (d->addSubscription(d->names, receiver, name, type)) {
+        entry.names.append(name);
+    }
+}
+
+void AbstractServer::subscribeSuffix(QObject *receiver, const QByteArray &suffix, quint16 type)
+{
+    AbstractServerPrivate::Receiver &entry = d->addReceiver(receiver);
+    if (d->addSubscription(d->suffixes, receiver, suffix, type)) {
+        entry.suffixes.append(suffix);
+    }
+}
+
+void AbstractServer::unsubscribe(QObject *receiver, const QByteArray &name, quint16 type)
+{
+    if (d->removeSubscription(d->names, receiver, name, type)) {
+        d->receivers[receiver].names.removeOne(name);
+    }
+}
+
+void AbstractServer::unsubscribeSuffix(QObject *receiver, const QByteArray &suffix, quint16 type)
+{
+    if (d->removeSubscription(d->suffixes, receiver, suffix, type)) {
+        d->receivers[receiver].suffixes.removeOne(suffix);
+    }
+}
+
+void AbstractServer::unsubscribeAll(QObject *receiver)
 {
+    if (d->receivers.contains(receiver)) {
+        disconnect(receiver, &QObject::destroyed, d, nullptr);
+        d->removeReceiver(receiver);
+    }
 }
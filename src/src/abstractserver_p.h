@@ -0,0 +1,110 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_ABSTRACTSERVER_P_H
+#define QMDNSENGINE_ABSTRACTSERVER_P_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QObject>
+#include <QPointer>
+#include <QSet>
+
+#include <qmdnsengine/abstractclock.h>
+#include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/histogram.h>
+#include <qmdnsengine/query.h>
+
+namespace QMdnsEngine
+{
+
+class Message;
+
+class AbstractServerPrivate : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    struct Subscription
+    {
+        QObject *receiver;
+        quint16 type;
+    };
+
+    struct Receiver
+    {
+        AbstractServer::Handler handler;
+        QList<QByteArray> names;
+        QList<QByteArray> suffixes;
+    };
+
+    struct Delivery
+    {
+        QPointer<QObject> receiver;
+        QList<Query> queries;
+        QList<int> records;
+        QSet<QByteArray> targets;
+    };
+
+    // Latencies of a responder and when it last answered (in the order of
+    // all answers recorded), so that the oldest can make room for others
+    struct ResponderLatency
+    {
+        Histogram histogram;
+        quint64 lastResponse;
+    };
+
+    explicit AbstractServerPrivate(AbstractServer *server);
+
+    Receiver &addReceiver(QObject *receiver);
+    void removeReceiver(QObject *receiver);
+
+    bool addSubscription(QHash<QByteArray, QList<Subscription>> &index, QObject *receiver, const QByteArray &key, quint16 type);
+    bool removeSubscription(QHash<QByteArray, QList<Subscription>> &index, QObject *receiver, const QByteArray &key, quint16 type);
+
+    void match(const QByteArray &name, quint16 type, QList<QObject*> &matches) const;
+    void matchType(const QList<Subscription> &subscriptions, quint16 type, QList<QObject*> &matches) const;
+
+    QHash<QByteArray, QList<Subscription>> names;
+    QHash<QByteArray, QList<Subscription>> suffixes;
+    QHash<QObject*, Receiver> receivers;
+
+    QPointer<AbstractClock> clock;
+
+    Histogram latencies[AbstractServer::ResponseLatency + 1];
+    QHash<QHostAddress, ResponderLatency> responseLatencies;
+    quint64 responseCount;
+
+private Q_SLOTS:
+
+    void onMessageReceived(const Message &message);
+    void onDestroyed(QObject *object);
+};
+
+}
+
+#endif // QMDNSENGINE_ABSTRACTSERVER_P_H
@@ -0,0 +1,857 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <climits>
+
+#include <QPointer>
+
+#include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/cache.h>
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/mdns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
+
+#include "browseengine_p.h"
+#include "knownanswers_p.h"
+
+using namespace QMdnsEngine;
+
+// Responses arriving later than this after a query are not counted as
+// answers to it
+const qint64 ResponseWindow = 1000;
+
+// Default bounds on the interval between queries (RFC 6762 section 5.2)
+const int DefaultMinimumInterval = 1000;
+const int DefaultMaximumInterval = 60 * 60 * 1000;
+
+// Names of the counters in BrowseEngine::Counter
+static const char *const CounterNames[] = {
+    "responses_received",
+    "queries_sent",
+    "refresh_queries",
+    "known_answers_omitted"
+};
+
+BrowseType::BrowseType(BrowseEngine *engine, const QByteArray &type)
+    : QObject(engine),
+      engine(engine),
+      server(engine->server),
+      cache(engine->cache),
+      type(type),
+      references(0),
+      activeReferences(0),
+      addressReferences(0),
+      lastQuery(-1),
+      minimumInterval(DefaultMinimumInterval),
+      maximumInterval(DefaultMaximumInterval),
+      queryInterval(DefaultMinimumInterval),
+      queryDelay(0),
+      nextQuery(0)
+{
+    server->setMessageHandler(this, [this](const Message &message) {
+        onMessageReceived(message);
+    });
+    if (type == MdnsBrowseType) {
+        server->subscribeSuffix(this, QByteArray(), PTR);
+        server->subscribeSuffix(this, QByteArray(), SRV);
+        server->subscribeSuffix(this, QByteArray(), TXT);
+    } else {
+        server->subscribe(this, type, PTR);
+        server->subscribeSuffix(this, type, SRV);
+        server->subscribeSuffix(this, type, TXT);
+    }
+    queryTimer.setClock(server->clock());
+    serviceTimer.setClock(server->clock());
+    connect(&queryTimer, &Timer::timeout, this, &BrowseType::onQueryTimeout);
+    connect(&serviceTimer, &Timer::timeout, this, &BrowseType::onServiceTimeout);
+    connect(server, &AbstractServer::interfacesChanged, this, &BrowseType::resetBackoff);
+
+    queryTimer.setSingleShot(true);
+
+    serviceTimer.setInterval(100);
+    serviceTimer.setSingleShot(true);
+}
+
+// Apply a record to a list of records with the same name and type the way
+// the cache does, returning true if the list changed; records that differ
+// only in TTL are considered equal
+static bool applyRecord(QList<Record> &records, const Record &record)
+{
+    if (!record.ttl()) {
+        return records.removeAll(record) > 0;
+    }
+    if (records.contains(record)) {
+        if (!record.flushCache() || records.count() == 1) {
+            return false;
+        }
+        records.clear();
+        records.append(record);
+        return true;
+    }
+    if (record.flushCache()) {
+        records.clear();
+    }
+    records.append(record);
+    return true;
+}
+
+BrowseType::Instance &BrowseType::instance(const QByteArray &fqName)
+{
+    auto i = instances.find(fqName);
+    if (i == instances.end()) {
+        // Start with the records already in the cache, which may have been
+        // added by others using it
+        Instance instance;
+        QList<Record> ptrRecords;
+        cache->lookupRecords(fqName.mid(fqName.indexOf('.') + 1), PTR, ptrRecords);
+        for (const Record &record : ptrRecords) {
+            instance.ptr = instance.ptr || record.target() == fqName;
+        }
+        cache->lookupRecords(fqName, SRV, instance.srvRecords);
+        cache->lookupRecords(fqName, TXT, instance.txtRecords);
+        i = instances.insert(fqName, instance);
+    }
+    return i.value();
+}
+
+QList<QHostAddress> BrowseType::lookupAddresses(const QList<Record> &srvRecords, const Record &expired) const
+{
+    QList<QHostAddress> addresses;
+    for (const Record &record : srvRecords) {
+        QList<Record> addressRecords;
+        cache->lookupRecords(record.target(), A, addressRecords);
+        cache->lookupRecords(record.target(), AAAA, addressRecords);
+        addressRecords.removeAll(expired);
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
+        for (const Record &addressRecord : std::as_const(addressRecords)) {
+#else
+        for (const Record &addressRecord : qAsConst(addressRecords)) {
+#endif
+            if (!addresses.contains(addressRecord.address())) {
+                addresses.append(addressRecord.address());
+            }
+        }
+    }
+    return addresses;
+}
+
+bool BrowseType::updateService(const QByteArray &fqName, int changes, const Record &expired)
+{
+    // Nothing can be reported without a PTR record and if a SRV record is
+    // missing, query for it (by returning true)
+    Instance &instance = instances[fqName];
+    if (!instance.ptr) {
+        return false;
+    }
+    if (instance.srvRecords.isEmpty()) {
+        return true;
+    }
+
+    // Only the fields affected by the changes are updated, unless the
+    // service has not been reported yet
+    const bool reported = services.contains(fqName);
+    Service &service = instance.service;
+    if (!reported) {
+        int index = fqName.indexOf('.');
+        service.setName(fqName.left(index));
+        service.setType(fqName.mid(index + 1));
+        changes |= SrvChanged | TxtChanged;
+    }
+
+    if (changes & SrvChanged) {
+
+        // The hostname and port are taken from the preferred SRV record
+        // (lowest priority, then highest weight)
+        Record srvRecord = instance.srvRecords.first();
+        QSet<QByteArray> hostnames;
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
+        for (const Record &record : std::as_const(instance.srvRecords)) {
+#else
+        for (const Record &record : qAsConst(instance.srvRecords)) {
+#endif
+            if (record.priority() < srvRecord.priority() ||
+                    (record.priority() == srvRecord.priority() && record.weight() > srvRecord.weight())) {
+                srvRecord = record;
+            }
+            hostnames.insert(record.target());
+            acquireHostname(record.target(), fqName);
+        }
+
+        // Drop the references to hosts that no SRV record points to any
+        // more (several records may share a host and a record may be
+        // replaced by one with a new port for the same host)
+        if (reported) {
+            const auto targets = service.targets();
+            for (const Record &record : targets) {
+                if (!hostnames.contains(record.target())) {
+                    releaseHostname(record.target(), fqName);
+                }
+            }
+        }
+
+        service.setHostname(srvRecord.target());
+        service.setPort(srvRecord.port());
+        service.setTargets(instance.srvRecords);
+        changes |= AddressesChanged;
+    }
+
+    if (changes & TxtChanged) {
+        QMap<QByteArray, QByteArray> attributes;
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
+        for (const Record &record : std::as_const(instance.txtRecords)) {
+#else
+        for (const Record &record : qAsConst(instance.txtRecords)) {
+#endif
+            for (auto i = record.attributes().constBegin();
+                    i != record.attributes().constEnd(); ++i) {
+                attributes.insert(i.key(), i.value());
+            }
+        }
+        service.setAttributes(attributes);
+    }
+
+    if (changes & AddressesChanged) {
+        QList<QHostAddress> addresses = lookupAddresses(instance.srvRecords, expired);
+        if (addresses == service.addresses()) {
+            changes &= ~AddressesChanged;
+        } else {
+            service.setAddresses(addresses);
+        }
+    }
+
+    // If the service existed, this is an update (which may only concern
+    // its addresses); otherwise it is a new addition; emit the appropriate
+    // signal (after the state is updated, since handlers may call back)
+    const Service copy = service;
+    if (!reported) {
+        services.insert(fqName, copy);
+        resetBackoff();
+        emit serviceAdded(copy);
+    } else if (changes & (SrvChanged | TxtChanged)) {
+        services.insert(fqName, copy);
+        emit serviceUpdated(copy);
+    } else if (changes & AddressesChanged) {
+        services.insert(fqName, copy);
+        emit addressesChanged(copy);
+    }
+
+    return false;
+}
+
+void BrowseType::updateAddresses(const QSet<QByteArray> &hostnames, QMap<QByteArray, int> &changes) const
+{
+    for (const QByteArray &hostname : hostnames) {
+        const auto fqNames = hostServices.value(hostname);
+        for (const QByteArray &fqName : fqNames) {
+            changes[fqName] |= AddressesChanged;
+        }
+    }
+}
+
+void BrowseType::acquireHostname(const QByteArray &hostname, const QByteArray &fqName)
+{
+    // Subscribe to address records when the first service uses the host
+
+    QSet<QByteArray> &fqNames = hostServices[hostname];
+    if (fqNames.isEmpty()) {
+        server->subscribe(this, hostname, A);
+        server->subscribe(this, hostname, AAAA);
+    }
+    fqNames.insert(fqName);
+}
+
+void BrowseType::releaseHostname(const QByteArray &hostname, const QByteArray &fqName)
+{
+    // Drop the subscription once the last service using the host is gone
+
+    auto i = hostServices.find(hostname);
+    if (i == hostServices.end() || !i.value().remove(fqName) || !i.value().isEmpty()) {
+        return;
+    }
+    hostServices.erase(i);
+    server->unsubscribe(this, hostname, A);
+    server->unsubscribe(this, hostname, AAAA);
+}
+
+void BrowseType::addAddressQueries(Message &message, const Service &service) const
+{
+    const auto targets = service.targets();
+    for (const Record &record : targets) {
+        Query query;
+        query.setName(record.target());
+        query.setType(A);
+        message.addQuery(query);
+        query.setType(AAAA);
+        message.addQuery(query);
+    }
+}
+
+void BrowseType::queryAddresses()
+{
+    Message message;
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
+    for (const Service &service : std::as_const(services)) {
+#else
+    for (const Service &service : qAsConst(services)) {
+#endif
+        if (service.addresses().isEmpty()) {
+            addAddressQueries(message, service);
+        }
+    }
+    if (!message.queries().isEmpty()) {
+        sendQuery(message);
+    }
+}
+
+void BrowseType::updateDiscovery()
+{
+    // A service is complete once its TXT records and at least one address
+    // for its host have been received
+
+    for (auto i = discoveryStarts.begin(); i != discoveryStarts.end();) {
+        auto instance = instances.constFind(i.key());
+        if (instance != instances.constEnd() && services.contains(i.key()) &&
+                !instance.value().txtRecords.isEmpty() &&
+                !instance.value().service.addresses().isEmpty()) {
+            server->recordLatency(AbstractServer::DiscoveryLatency,
+                                  currentTime(server->clock()) - i.value());
+            i = discoveryStarts.erase(i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+void BrowseType::sendQuery(const Message &message)
+{
+    if (!activeReferences) {
+        return;
+    }
+    engine->counters.add(BrowseEngine::QueriesSent);
+    lastQuery = currentTime(server->clock());
+    responders.clear();
+    server->sendMessageToAll(message);
+}
+
+void BrowseType::addQuery(Message &message, KnownAnswers &knownAnswers)
+{
+    Query query;
+    query.setName(type);
+    query.setType(PTR);
+    message.addQuery(query);
+
+    // Include PTR records for the target that are already known
+    knownAnswers.add(query.name(), PTR);
+
+    engine->counters.add(BrowseEngine::QueriesSent);
+    lastQuery = currentTime(server->clock());
+    responders.clear();
+    scheduleQuery();
+}
+
+void BrowseType::resetBackoff()
+{
+    // Start over with frequent queries, since the change may mean that
+    // services have appeared or disappeared
+
+    queryInterval = minimumInterval;
+    scheduleQuery();
+}
+
+void BrowseType::scheduleQuery()
+{
+    if (!activeReferences) {
+        queryTimer.stop();
+        return;
+    }
+
+    // Double the interval after each query up to the maximum
+    queryDelay = queryInterval;
+    nextQuery = currentTime(server->clock()) + queryDelay;
+    queryTimer.start(queryInterval);
+    queryInterval = queryInterval > maximumInterval / 2 ? maximumInterval : queryInterval * 2;
+}
+
+void BrowseType::setQueryInterval(QObject *browser, int minimum, int maximum)
+{
+    // Passive browsers send no queries, so their bounds do not apply
+    if (!intervals.contains(browser)) {
+        return;
+    }
+    intervals.insert(browser, qMakePair(minimum, maximum));
+    updateIntervals();
+    resetBackoff();
+}
+
+void BrowseType::updateIntervals()
+{
+    if (intervals.isEmpty()) {
+        minimumInterval = DefaultMinimumInterval;
+        maximumInterval = DefaultMaximumInterval;
+        return;
+    }
+    minimumInterval = INT_MAX;
+    maximumInterval = INT_MAX;
+    for (auto i = intervals.constBegin(); i != intervals.constEnd(); ++i) {
+        minimumInterval = qMin(minimumInterval, i.value().first);
+        maximumInterval = qMin(maximumInterval, i.value().second);
+    }
+    maximumInterval = qMax(minimumInterval, maximumInterval);
+}
+
+void BrowseType::onMessageReceived(const Message &message)
+{
+    if (!message.isResponse()) {
+        return;
+    }
+    engine->counters.add(BrowseEngine::ResponsesReceived);
+
+    // Record how long the responder took to answer the last query
+    const qint64 now = currentTime(server->clock());
+    if (lastQuery != -1 && !responders.contains(message.address())) {
+        responders.insert(message.address());
+        if (now - lastQuery <= ResponseWindow) {
+            server->recordLatency(AbstractServer::ResponseLatency, now - lastQuery, message.address());
+        }
+    }
+
+    const bool any = type == MdnsBrowseType;
+
+    // Track the changes to each service instance in the message so that
+    // each is updated (and queried) only once
+    QMap<QByteArray, int> changes;
+    QSet<QByteArray> srvTargets;
+    const auto records = message.records();
+    for (const Record &record : records) {
+        switch (record.type()) {
+        case PTR:
+            if (any && record.name() == MdnsBrowseType) {
+                ptrTargets.insert(record.target());
+                serviceTimer.start();
+                cache->addRecord(record);
+            } else if (any || record.name() == type) {
+                cache->addRecord(record);
+                if (!record.ttl()) {
+                    break;
+                }
+                Instance &instance = this->instance(record.target());
+                if (!instance.ptr || instance.srvRecords.isEmpty()) {
+                    instance.ptr = true;
+                    changes[record.target()] |= PtrChanged;
+                }
+                if (!services.contains(record.target()) &&
+                        !discoveryStarts.contains(record.target())) {
+                    discoveryStarts.insert(record.target(), now);
+                }
+            }
+            break;
+        case SRV:
+        case TXT:
+            if (any || record.name().endsWith("." + type)) {
+                cache->addRecord(record);
+                bool created = !instances.contains(record.name());
+                Instance &instance = this->instance(record.name());
+                int &change = changes[record.name()];
+                if (record.type() == SRV) {
+                    if (applyRecord(instance.srvRecords, record) || created) {
+                        change |= SrvChanged;
+                    }
+                    srvTargets.insert(record.target());
+                } else {
+                    if (applyRecord(instance.txtRecords, record) || created) {
+                        change |= TxtChanged;
+                    }
+                }
+            }
+            break;
+        }
+    }
+
+    // Cache A / AAAA records for known hostnames and the targets of the
+    // SRV records in the message so that services include their addresses
+    QSet<QByteArray> addressNames;
+    for (const Record &record : records) {
+        switch (record.type()) {
+        case A:
+        case AAAA:
+            if (hostServices.contains(record.name()) || srvTargets.contains(record.name())) {
+                cache->addRecord(record);
+                addressNames.insert(record.name());
+            }
+            break;
+        }
+    }
+    if (!addressNames.isEmpty()) {
+        updateAddresses(addressNames, changes);
+    }
+
+    // Update each of the services that changed and make a list of those
+    // missing SRV records
+    QSet<QByteArray> queryNames;
+    for (auto i = changes.constBegin(); i != changes.constEnd(); ++i) {
+        if (i.value() && updateService(i.key(), i.value())) {
+            queryNames.insert(i.key());
+        }
+    }
+
+    if (!discoveryStarts.isEmpty()) {
+        updateDiscovery();
+    }
+
+    // Build and send a query for all of the SRV and TXT records (and the
+    // addresses of services without any, if a browser is waiting for them)
+    Message queryMessage;
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
+    for (const QByteArray &name : std::as_const(queryNames)) {
+#else
+    for (const QByteArray &name : qAsConst(queryNames)) {
+#endif
+        Query query;
+        query.setName(name);
+        query.setType(SRV);
+        queryMessage.addQuery(query);
+        query.setType(TXT);
+        queryMessage.addQuery(query);
+    }
+    if (addressReferences) {
+        for (auto i = changes.constBegin(); i != changes.constEnd(); ++i) {
+            auto service = services.constFind(i.key());
+            if (i.value() && service != services.constEnd() && service.value().addresses().isEmpty()) {
+                addAddressQueries(queryMessage, service.value());
+            }
+        }
+    }
+    if (!queryMessage.queries().isEmpty()) {
+        sendQuery(queryMessage);
+    }
+
+    // Let browsers report the changes from the message together
+    emit batchFinished();
+}
+
+void BrowseType::recordExpired(const Record &record)
+{
+    // If the last SRV record has expired for a service, then it must be
+    // removed - TXT records and other SRV records on the other hand, cause
+    // an update (the expired record is still in the cache at this point);
+    // instances are forgotten once neither a PTR nor a SRV record is left
+
+    const bool any = type == MdnsBrowseType;
+    QByteArray fqName;
+    switch (record.type()) {
+    case PTR:
+        if (any ? record.name() == MdnsBrowseType : record.name() != type) {
+            return;
+        }
+        fqName = record.target();
+        break;
+    case SRV:
+    case TXT:
+        fqName = record.name();
+        break;
+    case A:
+    case AAAA:
+        if (hostServices.contains(record.name())) {
+            QMap<QByteArray, int> changes;
+            updateAddresses({record.name()}, changes);
+            for (auto i = changes.constBegin(); i != changes.constEnd(); ++i) {
+                updateService(i.key(), i.value(), record);
+            }
+        }
+        return;
+    default:
+        return;
+    }
+
+    auto i = instances.find(fqName);
+    if (i == instances.end()) {
+        return;
+    }
+    Instance &instance = i.value();
+    bool changed;
+    switch (record.type()) {
+    case PTR:
+        changed = instance.ptr;
+        instance.ptr = false;
+        break;
+    case SRV:
+        changed = instance.srvRecords.removeAll(record);
+        break;
+    default:
+        changed = instance.txtRecords.removeAll(record);
+        break;
+    }
+    if (!changed) {
+        return;
+    }
+
+    // A service that is still complete is updated; a PTR record on its own
+    // does not remove a service that has already been reported
+    if (!instance.srvRecords.isEmpty()) {
+        if (record.type() != PTR) {
+            updateService(fqName, record.type() == SRV ? SrvChanged : TxtChanged);
+        }
+        return;
+    }
+    if (!instance.ptr) {
+        instances.erase(i);
+    }
+    if (record.type() == TXT) {
+        return;
+    }
+
+    discoveryStarts.remove(fqName);
+    Service service = services.value(fqName);
+    if (!service.name().isNull()) {
+        resetBackoff();
+        services.remove(fqName);
+        const auto targets = service.targets();
+        for (const Record &target : targets) {
+            releaseHostname(target.target(), fqName);
+        }
+        emit serviceRemoved(service);
+    }
+}
+
+bool BrowseType::usesRecord(const Record &record) const
+{
+    const bool any = type == MdnsBrowseType;
+    switch (record.type()) {
+    case PTR:
+        return any || record.name() == type;
+    case SRV:
+    case TXT:
+        return any || record.name().endsWith("." + type);
+    case A:
+    case AAAA:
+        return hostServices.contains(record.name());
+    default:
+        return false;
+    }
+}
+
+void BrowseType::onQueryTimeout()
+{
+    engine->queueQuery(this);
+}
+
+void BrowseType::onServiceTimeout()
+{
+    if (ptrTargets.count()) {
+        Message message;
+        KnownAnswers knownAnswers(cache);
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
+		for (const QByteArray &target : std::as_const(ptrTargets)) {
+#else
+		for (const QByteArray &target : qAsConst(ptrTargets)) {
+#endif
+            // Add a query for PTR records
+            Query query;
+            query.setName(target);
+            query.setType(PTR);
+            message.addQuery(query);
+
+            // Include PTR records for the target that are already known
+            knownAnswers.add(target, PTR);
+        }
+        engine->counters.add(BrowseEngine::KnownAnswersOmitted, knownAnswers.addTo(message));
+
+        sendQuery(message);
+        ptrTargets.clear();
+    }
+}
+
+BrowseEngine::BrowseEngine(AbstractServer *server, Cache *existingCache)
+    : QObject(server),
+      server(server),
+      cache(existingCache ? existingCache : new Cache(this)),
+      existingCache(existingCache),
+      counters(CounterNames, CounterCount)
+{
+    flushTimer.setClock(server->clock());
+    flushTimer.setSingleShot(true);
+    connect(&flushTimer, &Timer::timeout, this, &BrowseEngine::flushQueries);
+
+    connect(cache, &Cache::shouldQuery, this, &BrowseEngine::onShouldQuery);
+    connect(cache, &Cache::recordExpired, this, &BrowseEngine::onRecordExpired);
+    if (!existingCache) {
+        cache->setClock(server->clock());
+    }
+}
+
+BrowseEngine *BrowseEngine::find(AbstractServer *server, Cache *cache)
+{
+    const auto engines = server->findChildren<BrowseEngine*>(QString(), Qt::FindDirectChildrenOnly);
+    for (BrowseEngine *engine : engines) {
+        if (engine->existingCache == cache) {
+            return engine;
+        }
+    }
+    return nullptr;
+}
+
+BrowseEngine *BrowseEngine::instance(AbstractServer *server, Cache *cache)
+{
+    BrowseEngine *engine = find(server, cache);
+    return engine ? engine : new BrowseEngine(server, cache);
+}
+
+BrowseType *BrowseEngine::acquire(const QByteArray &type, QObject *browser, bool passive)
+{
+    BrowseType *browseType = types.value(type);
+    if (!browseType) {
+        browseType = new BrowseType(this, type);
+        types.insert(type, browseType);
+    }
+    ++browseType->references;
+
+    if (passive) {
+        return browseType;
+    }
+    browseType->intervals.insert(browser, qMakePair(DefaultMinimumInterval, DefaultMaximumInterval));
+    browseType->updateIntervals();
+
+    // Begin querying for services with the next batch of queries once the
+    // first active browser arrives
+    if (!browseType->activeReferences++) {
+        browseType->queryInterval = browseType->minimumInterval;
+        queueQuery(browseType);
+    }
+    return browseType;
+}
+
+void BrowseEngine::release(BrowseType *browseType, QObject *browser, bool passive)
+{
+    if (!passive) {
+        browseType->intervals.remove(browser);
+        browseType->updateIntervals();
+    }
+    if (!passive && !--browseType->activeReferences) {
+        browseType->queryTimer.stop();
+        queued.removeOne(browseType);
+    }
+    if (--browseType->references) {
+        return;
+    }
+    types.remove(browseType->type);
+    queued.removeOne(browseType);
+    delete browseType;
+    if (types.isEmpty()) {
+        delete this;
+    }
+}
+
+void BrowseEngine::queueQuery(BrowseType *browseType)
+{
+    if (!queued.contains(browseType)) {
+        queued.append(browseType);
+    }
+    flushTimer.start(0);
+}
+
+void BrowseEngine::flushQueries()
+{
+    flushTimer.stop();
+    if (queued.isEmpty()) {
+        return;
+    }
+
+    // Bring forward the queries for other types that are due soon (less
+    // than half of their interval remains) so that the types stay in step
+    // and share packets from then on
+
+    const qint64 now = currentTime(server->clock());
+    for (BrowseType *browseType : types) {
+        if (browseType->activeReferences && !queued.contains(browseType) &&
+                browseType->nextQuery - now <= browseType->queryDelay / 2) {
+            queued.append(browseType);
+        }
+    }
+
+    // Send the questions for all of the types in a single message
+    Message message;
+    KnownAnswers knownAnswers(cache);
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
+    for (BrowseType *browseType : std::as_const(queued)) {
+#else
+    for (BrowseType *browseType : qAsConst(queued)) {
+#endif
+        browseType->addQuery(message, knownAnswers);
+    }
+    counters.add(KnownAnswersOmitted, knownAnswers.addTo(message));
+    queued.clear();
+    server->sendMessageToAll(message);
+}
+
+void BrowseEngine::onShouldQuery(const Record &record)
+{
+    // Assume that all records in the cache are still in use (by the
+    // browsers) and attempt to renew them immediately - but only on behalf
+    // of an active browser, since passive ones must not transmit; records
+    // that no type uses (in a cache shared with others) are renewed as long
+    // as any browser is active
+
+    bool used = false;
+    bool active = false;
+    bool anyActive = false;
+    for (BrowseType *browseType : types) {
+        anyActive = anyActive || browseType->activeReferences;
+        if (browseType->usesRecord(record)) {
+            used = true;
+            active = active || browseType->activeReferences;
+        }
+    }
+    if (used ? !active : !anyActive) {
+        return;
+    }
+
+    Query query;
+    query.setName(record.name());
+    query.setType(record.type());
+    Message message;
+    message.addQuery(query);
+    counters.add(RefreshQueries);
+    server->sendMessageToAll(message);
+}
+
+void BrowseEngine::onRecordExpired(const Record &record)
+{
+    // A browser may be deleted when it is notified, taking its type (and
+    // possibly the engine) with it
+
+    QList<QPointer<BrowseType>> browseTypes;
+    for (BrowseType *browseType : types) {
+        browseTypes.append(browseType);
+    }
+    for (const QPointer<BrowseType> &browseType : browseTypes) {
+        if (browseType) {
+            browseType->recordExpired(record);
+        }
+        if (browseType) {
+            emit browseType->batchFinished();
+        }
+    }
+}
@@ -0,0 +1,213 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_BROWSEENGINE_P_H
+#define QMDNSENGINE_BROWSEENGINE_P_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QPair>
+#include <QSet>
+
+#include <qmdnsengine/record.h>
+#include <qmdnsengine/service.h>
+
+#include "counters_p.h"
+#include "timer_p.h"
+
+namespace QMdnsEngine
+{
+
+class AbstractServer;
+class BrowseEngine;
+class Cache;
+class KnownAnswers;
+class Message;
+
+// Queries and services for a single type, shared by every Browser for that
+// type on the same engine
+
+class BrowseType : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    // Parts of a service instance that changed
+    enum Change {
+        PtrChanged = 1,
+        SrvChanged = 2,
+        TxtChanged = 4,
+        AddressesChanged = 8
+    };
+
+    // Records received for a service instance and the service built from
+    // them, which is reported once a PTR record and SRV record are known
+    struct Instance
+    {
+        Instance() : ptr(false) {}
+
+        bool ptr;
+        QList<Record> srvRecords;
+        QList<Record> txtRecords;
+        Service service;
+    };
+
+    BrowseType(BrowseEngine *engine, const QByteArray &type);
+
+    Instance &instance(const QByteArray &fqName);
+    QList<QHostAddress> lookupAddresses(const QList<Record> &srvRecords, const Record &expired) const;
+    bool updateService(const QByteArray &fqName, int changes, const Record &expired = Record());
+    void updateAddresses(const QSet<QByteArray> &hostnames, QMap<QByteArray, int> &changes) const;
+    void acquireHostname(const QByteArray &hostname, const QByteArray &fqName);
+    void releaseHostname(const QByteArray &hostname, const QByteArray &fqName);
+    void addAddressQueries(Message &message, const Service &service) const;
+    void queryAddresses();
+    void updateDiscovery();
+    void sendQuery(const Message &message);
+    void addQuery(Message &message, KnownAnswers &knownAnswers);
+    void resetBackoff();
+    void scheduleQuery();
+    void setQueryInterval(QObject *browser, int minimum, int maximum);
+    void updateIntervals();
+
+    void recordExpired(const Record &record);
+
+    // Whether the record is one the type browses or resolves with
+    bool usesRecord(const Record &record) const;
+
+    BrowseEngine *const engine;
+    AbstractServer *const server;
+    Cache *const cache;
+    const QByteArray type;
+    int references;
+
+    // Number of browsers that are not passive; without any, the type only
+    // overhears responses and never transmits
+    int activeReferences;
+
+    // Number of browsers waiting for the addresses of services
+    int addressReferences;
+
+    QSet<QByteArray> ptrTargets;
+    QHash<QByteArray, Instance> instances;
+    QMap<QByteArray, Service> services;
+
+    // Services using each host as a target; address records are cached for
+    // (and subscribed to) these hosts only
+    QHash<QByteArray, QSet<QByteArray>> hostServices;
+
+    // Time the first PTR record was received for each service that is not
+    // yet complete, and the responders that answered the last query
+    QMap<QByteArray, qint64> discoveryStarts;
+    qint64 lastQuery;
+    QSet<QHostAddress> responders;
+
+    Timer queryTimer;
+    Timer serviceTimer;
+
+    // Bounds on the interval requested by each active browser; the type
+    // uses the smallest minimum and the smallest maximum among them
+    QHash<QObject*, QPair<int, int>> intervals;
+    int minimumInterval;
+    int maximumInterval;
+    int queryInterval;
+    int queryDelay;
+    qint64 nextQuery;
+
+Q_SIGNALS:
+
+    void serviceAdded(const Service &service);
+    void serviceUpdated(const Service &service);
+    void serviceRemoved(const Service &service);
+    void addressesChanged(const Service &service);
+
+    // The changes from a message or an expired record have all been
+    // reported
+    void batchFinished();
+
+private Q_SLOTS:
+
+    void onMessageReceived(const Message &message);
+
+    void onQueryTimeout();
+    void onServiceTimeout();
+};
+
+// One engine exists for each server and cache (or lack of one) used by
+// browsers; it holds the cache and the types currently being browsed and
+// is destroyed along with the last of them
+
+class BrowseEngine : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    // The traffic of all browsers using the engine is counted once here
+    enum Counter {
+        ResponsesReceived,
+        QueriesSent,
+        RefreshQueries,
+        KnownAnswersOmitted,
+        CounterCount
+    };
+
+    static BrowseEngine *find(AbstractServer *server, Cache *cache);
+    static BrowseEngine *instance(AbstractServer *server, Cache *cache);
+
+    BrowseType *acquire(const QByteArray &type, QObject *browser, bool passive);
+    void release(BrowseType *browseType, QObject *browser, bool passive);
+
+    void queueQuery(BrowseType *browseType);
+    void flushQueries();
+
+    AbstractServer *const server;
+    Cache *const cache;
+    Cache *const existingCache;
+    QHash<QByteArray, BrowseType*> types;
+
+    // Types with a query waiting to be sent in the next message
+    QList<BrowseType*> queued;
+    Timer flushTimer;
+
+    Counters counters;
+
+private Q_SLOTS:
+
+    void onShouldQuery(const Record &record);
+    void onRecordExpired(const Record &record);
+
+private:
+
+    BrowseEngine(AbstractServer *server, Cache *existingCache);
+};
+
+}
+
+#endif // QMDNSENGINE_BROWSEENGINE_P_H
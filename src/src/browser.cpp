@@ -22,295 +22,378 @@
  * IN THE SOFTWARE.
  */
 
-#include <utility>
-
 #include <qmdnsengine/abstractserver.h>
 #include <qmdnsengine/browser.h>
-#include <qmdnsengine/cache.h>
-#include <qmdnsengine/dns.h>
-#include <qmdnsengine/mdns.h>
-#include <qmdnsengine/message.h>
-#include <qmdnsengine/query.h>
-#include <qmdnsengine/record.h>
+#include <qmdnsengine/statistics.h>
 
+#include "browseengine_p.h"
 #include "browser_p.h"
 
 using namespace QMdnsEngine;
 
-BrowserPrivate::BrowserPrivate(Browser *browser, AbstractServer *server, const QByteArray &type, Cache *existingCache)
+// Time to wait for the address of a service before reporting it anyway
+const int DefaultResolveTimeout = 2000;
+
+// Names of the counters in BrowserPrivate::Counter
+static const char *const CounterNames[] = {
+    "services_added",
+    "services_updated",
+    "services_removed"
+};
+
+static QByteArray serviceKey(const Service &service)
+{
+    return service.name() + "." + service.type();
+}
+
+BrowserPrivate::BrowserPrivate(Browser *browser, AbstractServer *server, const QList<QByteArray> &types,
+                               Browser::Mode mode, Cache *existingCache)
     : QObject(browser),
       server(server),
-      type(type),
-      cache(existingCache ? existingCache : new Cache(this)),
+      engine(BrowseEngine::instance(server, existingCache)),
+      mode(mode),
+      resolveAddresses(false),
+      resolveTimeout(DefaultResolveTimeout),
+      counters(CounterNames, CounterCount),
       q(browser)
 {
-    connect(server, &AbstractServer::messageReceived, this, &BrowserPrivate::onMessageReceived);
-    connect(cache, &Cache::shouldQuery, this, &BrowserPrivate::onShouldQuery);
-    connect(cache, &Cache::recordExpired, this, &BrowserPrivate::onRecordExpired);
-    connect(&queryTimer, &QTimer::timeout, this, &BrowserPrivate::onQueryTimeout);
-    connect(&serviceTimer, &QTimer::timeout, this, &BrowserPrivate::onServiceTimeout);
+    for (const QByteArray &type : types) {
+        if (this->types.contains(type)) {
+            continue;
+        }
+        BrowseType *browseType = engine->acquire(type, this, mode == Browser::Passive);
+        connect(browseType, &BrowseType::serviceAdded, this, &BrowserPrivate::onServiceAdded);
+        connect(browseType, &BrowseType::serviceUpdated, this, &BrowserPrivate::onServiceUpdated);
+        connect(browseType, &BrowseType::serviceRemoved, this, &BrowserPrivate::onServiceRemoved);
+        connect(browseType, &BrowseType::addressesChanged, this, &BrowserPrivate::onAddressesChanged);
+        connect(browseType, &BrowseType::batchFinished, this, &BrowserPrivate::flushBatch);
+        this->types.append(type);
+        browseTypes.append(browseType);
+
+        // If other browsers are already browsing for the type, report the
+        // services they found
+        existing.append(browseType->services.values());
+    }
 
-    queryTimer.setInterval(60 * 1000);
-    queryTimer.setSingleShot(true);
+    // Send the queries for any new types together
+    engine->flushQueries();
 
-    serviceTimer.setInterval(100);
-    serviceTimer.setSingleShot(true);
+    existingTimer.setClock(server->clock());
+    existingTimer.setSingleShot(true);
+    connect(&existingTimer, &Timer::timeout, this, &BrowserPrivate::onExistingTimeout);
+    if (!existing.isEmpty()) {
+        existingTimer.start(0);
+    }
 
-    // Immediately begin browsing for services
-    onQueryTimeout();
+    pendingTimer.setClock(server->clock());
+    pendingTimer.setSingleShot(true);
+    connect(&pendingTimer, &Timer::timeout, this, &BrowserPrivate::onPendingTimeout);
 }
 
-// TODO: multiple SRV records not supported
-
-bool BrowserPrivate::updateService(const QByteArray &fqName)
+BrowserPrivate::~BrowserPrivate()
 {
-    // Split the FQDN into service name and type
-    int index = fqName.indexOf('.');
-    QByteArray serviceName = fqName.left(index);
-    QByteArray serviceType = fqName.mid(index + 1);
-
-    // Immediately return if a PTR record does not exist
-    Record ptrRecord;
-    if (!cache->lookupRecord(serviceType, PTR, ptrRecord)) {
-        return false;
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
+    for (const QPointer<BrowseType> &browseType : std::as_const(browseTypes)) {
+#else
+    for (const QPointer<BrowseType> &browseType : qAsConst(browseTypes)) {
+#endif
+        if (engine && browseType) {
+            if (resolveAddresses) {
+                --browseType->addressReferences;
+            }
+            engine->release(browseType, this, mode == Browser::Passive);
+        }
     }
+}
 
-    // If a SRV record is missing, query for it (by returning true)
-    Record srvRecord;
-    if (!cache->lookupRecord(fqName, SRV, srvRecord)) {
-        return true;
+void BrowserPrivate::setResolveAddresses(bool resolve, int timeout)
+{
+    resolveTimeout = timeout;
+    if (resolve == resolveAddresses) {
+        return;
     }
+    resolveAddresses = resolve;
 
-    Service service;
-    service.setName(serviceName);
-    service.setType(serviceType);
-    service.setHostname(srvRecord.target());
-    service.setPort(srvRecord.port());
-
-    // If TXT records are available for the service, add their values
-    QList<Record> txtRecords;
-    if (cache->lookupRecords(fqName, TXT, txtRecords)) {
-        QMap<QByteArray, QByteArray> attributes;
 #if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
-		for (const Record &record : std::as_const(txtRecords)) {
+    for (const QPointer<BrowseType> &browseType : std::as_const(browseTypes)) {
 #else
-		for (const Record &record : qAsConst(txtRecords)) {
+    for (const QPointer<BrowseType> &browseType : qAsConst(browseTypes)) {
 #endif
-            for (auto i = record.attributes().constBegin();
-                    i != record.attributes().constEnd(); ++i) {
-                attributes.insert(i.key(), i.value());
-            }
+        if (!browseType) {
+            continue;
+        }
+        if (resolve) {
+            ++browseType->addressReferences;
+            browseType->queryAddresses();
+        } else {
+            --browseType->addressReferences;
         }
-        service.setAttributes(attributes);
     }
 
-    // If the service existed, this is an update; otherwise it is a new
-    // addition; emit the appropriate signal
-    if (!services.contains(fqName)) {
-        emit q->serviceAdded(service);
-    } else if(services.value(fqName) != service) {
-        emit q->serviceUpdated(service);
+    // Stop waiting for the addresses of any pending services
+    if (!resolve) {
+        const QList<Service> services = pending.values();
+        pending.clear();
+        deadlines.clear();
+        pendingTimer.stop();
+        for (const Service &service : services) {
+            notifyAdded(service);
+        }
+        flushBatch();
     }
-
-    services.insert(fqName, service);
-    hostnames.insert(service.hostname());
-
-    return false;
 }
 
-void BrowserPrivate::onMessageReceived(const Message &message)
+int BrowserPrivate::existingIndex(const Service &service) const
 {
-    if (!message.isResponse()) {
-        return;
+    for (int i = 0; i < existing.count(); ++i) {
+        if (existing.at(i).name() == service.name() && existing.at(i).type() == service.type()) {
+            return i;
+        }
     }
+    return -1;
+}
 
-    const bool any = type == MdnsBrowseType;
-
-    // Use a set to track all services that are updated in the message to
-    // prevent unnecessary queries for SRV and TXT records
-    QSet<QByteArray> updateNames;
-    const auto records = message.records();
-    for (const Record &record : records) {
-        bool cacheRecord = false;
-
-        switch (record.type()) {
-        case PTR:
-            if (any && record.name() == MdnsBrowseType) {
-                ptrTargets.insert(record.target());
-                serviceTimer.start();
-                cacheRecord = true;
-            } else if (any || record.name() == type) {
-                updateNames.insert(record.target());
-                cacheRecord = true;
-            }
-            break;
-        case SRV:
-        case TXT:
-            if (any || record.name().endsWith("." + type)) {
-                updateNames.insert(record.name());
-                cacheRecord = true;
-            }
-            break;
-        }
-        if (cacheRecord) {
-            cache->addRecord(record);
+void BrowserPrivate::reportAdded(const Service &service)
+{
+    // Hold on to services without addresses when waiting for them
+
+    if (resolveAddresses && service.addresses().isEmpty()) {
+        QByteArray key = serviceKey(service);
+        pending.insert(key, service);
+        deadlines.insert(key, currentTime(server->clock()) + resolveTimeout);
+        if (!pendingTimer.isActive()) {
+            pendingTimer.start(resolveTimeout);
         }
+        return;
     }
+    notifyAdded(service);
+}
 
-    // For each of the services marked to be updated, perform the update and
-    // make a list of all missing SRV records
-    QSet<QByteArray> queryNames;
-#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
-	for (const QByteArray &name : std::as_const(updateNames)) {
-#else
-	for (const QByteArray &name : qAsConst(updateNames)) {
-#endif
-        if (updateService(name)) {
-            queryNames.insert(name);
+bool BrowserPrivate::updatePending(const Service &service)
+{
+    // Changes to services that have not been reported yet are folded into
+    // the report
+
+    int index = existingIndex(service);
+    if (index != -1) {
+        existing[index] = service;
+        return true;
+    }
+    QByteArray key = serviceKey(service);
+    if (pending.contains(key)) {
+        if (service.addresses().isEmpty()) {
+            pending.insert(key, service);
+        } else {
+            pending.remove(key);
+            deadlines.remove(key);
+            notifyAdded(service);
         }
+        return true;
     }
+    return false;
+}
 
-    // Cache A / AAAA records after services are processed to ensure hostnames are known
-    for (const Record &record : records) {
-        bool cacheRecord = false;
+void BrowserPrivate::notifyAdded(const Service &service)
+{
+    // A service removed and added again in the same batch was only updated
+
+    QByteArray key = serviceKey(service);
+    reported.insert(key, service);
+    if (removedBatch.remove(key)) {
+        updatedBatch.insert(key, service);
+    } else {
+        addedBatch.insert(key, service);
+    }
+    counters.add(ServicesAdded);
+    emit q->serviceAdded(service);
+}
 
-        switch (record.type()) {
-            case A:
-            case AAAA:
-                cacheRecord = hostnames.contains(record.name());
-                break;
-        }
-        if (cacheRecord) {
-            cache->addRecord(record);
-        }
+void BrowserPrivate::notifyUpdated(const Service &service)
+{
+    QByteArray key = serviceKey(service);
+    reported.insert(key, service);
+    if (addedBatch.contains(key)) {
+        addedBatch.insert(key, service);
+    } else {
+        updatedBatch.insert(key, service);
     }
+    counters.add(ServicesUpdated);
+    emit q->serviceUpdated(service);
+}
 
-    // Build and send a query for all of the SRV and TXT records
-    if (queryNames.count()) {
-        Message queryMessage;
-#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
-		for (const QByteArray &name : std::as_const(queryNames)) {
-#else
-		for (const QByteArray &name : qAsConst(queryNames)) {
-#endif
-            Query query;
-            query.setName(name);
-            query.setType(SRV);
-            queryMessage.addQuery(query);
-            query.setType(TXT);
-            queryMessage.addQuery(query);
-        }
-        server->sendMessageToAll(queryMessage);
+void BrowserPrivate::notifyRemoved(const Service &service)
+{
+    // A service added and removed again in the same batch is left out
+    // entirely
+
+    QByteArray key = serviceKey(service);
+    reported.remove(key);
+    updatedBatch.remove(key);
+    if (!addedBatch.remove(key)) {
+        removedBatch.insert(key, service);
     }
+    counters.add(ServicesRemoved);
+    emit q->serviceRemoved(service);
 }
 
-void BrowserPrivate::onShouldQuery(const Record &record)
+void BrowserPrivate::onServiceAdded(const Service &service)
 {
-    // Assume that all messages in the cache are still in use (by the browser)
-    // and attempt to renew them immediately
-
-    Query query;
-    query.setName(record.name());
-    query.setType(record.type());
-    Message message;
-    message.addQuery(query);
-    server->sendMessageToAll(message);
+    reportAdded(service);
 }
 
-void BrowserPrivate::onRecordExpired(const Record &record)
+void BrowserPrivate::onServiceUpdated(const Service &service)
 {
-    // If the SRV record has expired for a service, then it must be
-    // removed - TXT records on the other hand, cause an update
-
-    QByteArray serviceName;
-    switch (record.type()) {
-    case SRV:
-        serviceName = record.name();
-        break;
-    case TXT:
-        updateService(record.name());
-        return;
-    default:
+    if (!updatePending(service)) {
+        notifyUpdated(service);
+    }
+}
+
+void BrowserPrivate::onServiceRemoved(const Service &service)
+{
+    int index = existingIndex(service);
+    if (index != -1) {
+        existing.removeAt(index);
         return;
     }
-    Service service = services.value(serviceName);
-    if (!service.name().isNull()) {
-        emit q->serviceRemoved(service);
-        services.remove(serviceName);
-        updateHostnames();
+    QByteArray key = serviceKey(service);
+    if (pending.remove(key)) {
+        deadlines.remove(key);
+        return;
     }
+    notifyRemoved(service);
 }
 
-void BrowserPrivate::onQueryTimeout()
+void BrowserPrivate::onAddressesChanged(const Service &service)
 {
-    Query query;
-    query.setName(type);
-    query.setType(PTR);
-    Message message;
-    message.addQuery(query);
+    if (!updatePending(service) && resolveAddresses) {
+        notifyUpdated(service);
+    }
+}
 
-    // TODO: including too many records could cause problems
+void BrowserPrivate::onExistingTimeout()
+{
+    const QList<Service> services = existing;
+    existing.clear();
+    for (const Service &service : services) {
+        reportAdded(service);
+    }
+    flushBatch();
+}
 
-    // Include PTR records for the target that are already known
-    QList<Record> records;
-    if (cache->lookupRecords(query.name(), PTR, records)) {
-#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
-		for (const Record &record : std::as_const(records)) {
-#else
-		for (const Record &record : qAsConst(records)) {
-#endif
-            message.addRecord(record);
+void BrowserPrivate::onPendingTimeout()
+{
+    // Report the services that have waited long enough and wait for the
+    // next one (if any)
+
+    qint64 now = currentTime(server->clock());
+    qint64 next = -1;
+    QList<Service> services;
+    for (auto i = deadlines.begin(); i != deadlines.end();) {
+        if (i.value() <= now) {
+            services.append(pending.take(i.key()));
+            i = deadlines.erase(i);
+        } else {
+            if (next == -1 || i.value() < next) {
+                next = i.value();
+            }
+            ++i;
         }
     }
+    if (next != -1) {
+        pendingTimer.start(static_cast<int>(next - now));
+    }
+    for (const Service &service : services) {
+        notifyAdded(service);
+    }
+    flushBatch();
+}
+
+void BrowserPrivate::flushBatch()
+{
+    // Take the changes first, since handlers may cause more of them
+
+    const QList<Service> removed = removedBatch.values();
+    const QList<Service> added = addedBatch.values();
+    const QList<Service> updated = updatedBatch.values();
+    removedBatch.clear();
+    addedBatch.clear();
+    updatedBatch.clear();
 
-    server->sendMessageToAll(message);
-    queryTimer.start();
+    if (!removed.isEmpty()) {
+        emit q->servicesRemoved(removed);
+    }
+    if (!added.isEmpty()) {
+        emit q->servicesAdded(added);
+    }
+    if (!updated.isEmpty()) {
+        emit q->servicesUpdated(updated);
+    }
 }
 
-void BrowserPrivate::onServiceTimeout()
+Browser::Browser(AbstractServer *server, const QByteArray &type, Cache *cache, QObject *parent)
+    : QObject(parent),
+      d(new BrowserPrivate(this, server, {type}, Active, cache))
+{
+}
+
+Browser::Browser(AbstractServer *server, const QByteArray &type, Mode mode, Cache *cache, QObject *parent)
+    : QObject(parent),
+      d(new BrowserPrivate(this, server, {type}, mode, cache))
+{
+}
+
+Browser::Browser(AbstractServer *server, const QList<QByteArray> &types, Cache *cache, QObject *parent)
+    : QObject(parent),
+      d(new BrowserPrivate(this, server, types, Active, cache))
+{
+}
+
+Browser::Browser(AbstractServer *server, const QList<QByteArray> &types, Mode mode, Cache *cache, QObject *parent)
+    : QObject(parent),
+      d(new BrowserPrivate(this, server, types, mode, cache))
+{
+}
+
+void Browser::setResolveAddresses(bool resolve, int timeout)
+{
+    d->setResolveAddresses(resolve, timeout);
+}
+
+QList<QByteArray> Browser::types() const
+{
+    return d->types;
+}
+
+Browser::Mode Browser::mode() const
+{
+    return d->mode;
+}
+
+QList<Service> Browser::services() const
+{
+    return d->reported.values();
+}
+
+void Browser::setQueryInterval(int minimum, int maximum)
 {
-    if (ptrTargets.count()) {
-        Message message;
-#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
-		for (const QByteArray &target : std::as_const(ptrTargets)) {
-#else
-		for (const QByteArray &target : qAsConst(ptrTargets)) {
-#endif
-            // Add a query for PTR records
-            Query query;
-            query.setName(target);
-            query.setType(PTR);
-            message.addQuery(query);
-
-            // Include PTR records for the target that are already known
-            QList<Record> records;
-            if (cache->lookupRecords(target, PTR, records)) {
 #if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
-				for (const Record &record : std::as_const(records)) {
+    for (const QPointer<BrowseType> &browseType : std::as_const(d->browseTypes)) {
 #else
-				for (const Record &record : qAsConst(records)) {
+    for (const QPointer<BrowseType> &browseType : qAsConst(d->browseTypes)) {
 #endif
-                    message.addRecord(record);
-                }
-            }
+        if (browseType) {
+            browseType->setQueryInterval(d, minimum, maximum);
         }
-
-        server->sendMessageToAll(message);
-        ptrTargets.clear();
     }
 }
 
-void BrowserPrivate::updateHostnames()
+Statistics Browser::statistics() const
 {
-    hostnames.clear();
-
-    for (const auto& service : services) {
-        hostnames.insert(service.hostname());
-    }
+    return d->counters.statistics();
 }
 
-Browser::Browser(AbstractServer *server, const QByteArray &type, Cache *cache, QObject *parent)
-    : QObject(parent),
-      d(new BrowserPrivate(this, server, type, cache))
+Statistics Browser::sharedStatistics(AbstractServer *server, Cache *cache)
 {
+    BrowseEngine *engine = BrowseEngine::find(server, cache);
+    return engine ? engine->counters.statistics() : Statistics();
 }
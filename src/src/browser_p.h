@@ -26,21 +26,25 @@
 #define QMDNSENGINE_BROWSER_P_H
 
 #include <QByteArray>
+#include <QList>
 #include <QMap>
 #include <QObject>
-#include <QSet>
-#include <QTimer>
+#include <QPointer>
 
+#include <qmdnsengine/browser.h>
 #include <qmdnsengine/service.h>
 
+#include "counters_p.h"
+#include "timer_p.h"
+
 namespace QMdnsEngine
 {
 
 class AbstractServer;
+class BrowseEngine;
+class BrowseType;
 class Browser;
 class Cache;
-class Message;
-class Record;
 
 class BrowserPrivate : public QObject
 {
@@ -48,32 +52,70 @@ class BrowserPrivate : public QObject
 
 public:
 
-    explicit BrowserPrivate(Browser *browser, AbstractServer *server, const QByteArray &type, Cache *existingCache);
+    enum Counter {
+        ServicesAdded,
+        ServicesUpdated,
+        ServicesRemoved,
+        CounterCount
+    };
+
+    explicit BrowserPrivate(Browser *browser, AbstractServer *server, const QList<QByteArray> &types,
+                            Browser::Mode mode, Cache *existingCache);
+    virtual ~BrowserPrivate();
 
-    bool updateService(const QByteArray &fqName);
+    void setResolveAddresses(bool resolve, int timeout);
 
     AbstractServer *server;
-    QByteArray type;
+    QPointer<BrowseEngine> engine;
+    QList<QByteArray> types;
+    QList<QPointer<BrowseType>> browseTypes;
+    Browser::Mode mode;
+
+    bool resolveAddresses;
+    int resolveTimeout;
+
+    // Services that were known before the browser was created; they are
+    // reported once control returns to the event loop
+    QList<Service> existing;
+    Timer existingTimer;
+
+    // Services waiting for an address and the time at which they are
+    // reported regardless
+    QMap<QByteArray, Service> pending;
+    QMap<QByteArray, qint64> deadlines;
+    Timer pendingTimer;
 
-    Cache *cache;
-    QSet<QByteArray> ptrTargets;
-    QMap<QByteArray, Service> services;
-    QSet<QByteArray> hostnames;
+    // Services reported to the application
+    QMap<QByteArray, Service> reported;
 
-    QTimer queryTimer;
-    QTimer serviceTimer;
+    // Net changes since the last batch; each service is in at most one
+    QMap<QByteArray, Service> addedBatch;
+    QMap<QByteArray, Service> updatedBatch;
+    QMap<QByteArray, Service> removedBatch;
+
+    Counters counters;
 
 private Q_SLOTS:
 
-    void onMessageReceived(const Message &message);
-    void onShouldQuery(const Record &record);
-    void onRecordExpired(const Record &record);
+    void onServiceAdded(const Service &service);
+    void onServiceUpdated(const Service &service);
+    void onServiceRemoved(const Service &service);
+    void onAddressesChanged(const Service &service);
+
+    void onExistingTimeout();
+    void onPendingTimeout();
 
-    void onQueryTimeout();
-    void onServiceTimeout();
+    void flushBatch();
 
 private:
-    void updateHostnames();
+
+    int existingIndex(const Service &service) const;
+    void reportAdded(const Service &service);
+    bool updatePending(const Service &service);
+
+    void notifyAdded(const Service &service);
+    void notifyUpdated(const Service &service);
+    void notifyRemoved(const Service &service);
 
     Browser *const q;
 };
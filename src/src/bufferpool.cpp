@@ -0,0 +1,160 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include "bufferpool_p.h"
+
+using namespace QMdnsEngine;
+
+BufferPool::Buffer::Buffer()
+    : block(nullptr)
+{
+}
+
+BufferPool::Buffer::Buffer(Block *block)
+    : block(block)
+{
+}
+
+BufferPool::Buffer::Buffer(const Buffer &other)
+    : block(other.block)
+{
+    if (block) {
+        block->ref.ref();
+    }
+}
+
+BufferPool::Buffer &BufferPool::Buffer::operator=(const Buffer &other)
+{
+    if (other.block) {
+        other.block->ref.ref();
+    }
+    release();
+    block = other.block;
+    return *this;
+}
+
+BufferPool::Buffer::~Buffer()
+{
+    release();
+}
+
+bool BufferPool::Buffer::isNull() const
+{
+    return !block;
+}
+
+char *BufferPool::Buffer::data() const
+{
+    return block ? block->data : nullptr;
+}
+
+int BufferPool::Buffer::size() const
+{
+    return block ? block->size : 0;
+}
+
+void BufferPool::Buffer::setSize(int size)
+{
+    block->size = size;
+}
+
+QByteArray BufferPool::Buffer::toByteArray() const
+{
+    return block ? QByteArray::fromRawData(block->data, block->size) : QByteArray();
+}
+
+void BufferPool::Buffer::release()
+{
+    if (block && !block->ref.deref()) {
+        if (block->pool) {
+            block->pool->recycle(block);
+        } else {
+            delete[] block->data;
+            delete block;
+        }
+    }
+    block = nullptr;
+}
+
+BufferPool::BufferPool(int bufferSize, int count)
+    : bufferSize(bufferSize),
+      count(count),
+      slab(new char[bufferSize * count]),
+      blocks(new Block[count]),
+      freeHead(0)
+{
+    // Chain every block into the freelist
+    for (int i = 0; i < count; ++i) {
+        blocks[i].pool = this;
+        blocks[i].data = slab + i * bufferSize;
+        blocks[i].size = 0;
+        blocks[i].next.storeRelease(i + 1 < count ? i + 2 : 0);
+    }
+    freeHead.storeRelease(count ? 1 : 0);
+}
+
+BufferPool::~BufferPool()
+{
+    delete[] blocks;
+    delete[] slab;
+}
+
+BufferPool::Buffer BufferPool::acquire()
+{
+    quint64 head = freeHead.loadAcquire();
+    forever {
+        quint32 index = head & 0xffffffff;
+        if (!index) {
+            break;
+        }
+        Block *block = &blocks[index - 1];
+        quint64 newHead = (((head >> 32) + 1) << 32) | block->next.loadAcquire();
+        if (freeHead.testAndSetOrdered(head, newHead, head)) {
+            block->ref.storeRelease(1);
+            block->size = bufferSize;
+            return Buffer(block);
+        }
+    }
+
+    // The pool is exhausted, so fall back to the heap
+    Block *block = new Block;
+    block->pool = nullptr;
+    block->data = new char[bufferSize];
+    block->size = bufferSize;
+    block->ref.storeRelease(1);
+    return Buffer(block);
+}
+
+void BufferPool::recycle(Block *block)
+{
+    quint32 index = static_cast<quint32>(block - blocks) + 1;
+    quint64 head = freeHead.loadAcquire();
+    forever {
+        block->next.storeRelease(head & 0xffffffff);
+        quint64 newHead = (((head >> 32) + 1) << 32) | index;
+        if (freeHead.testAndSetOrdered(head, newHead, head)) {
+            break;
+        }
+    }
+}
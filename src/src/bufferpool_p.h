@@ -0,0 +1,105 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_BUFFERPOOL_P_H
+#define QMDNSENGINE_BUFFERPOOL_P_H
+
+#include <QAtomicInt>
+#include <QAtomicInteger>
+#include <QByteArray>
+
+namespace QMdnsEngine
+{
+
+// Fixed-size buffers allocated in a single slab and recycled through a
+// lock-free freelist; a buffer returns to the pool when the last handle to it
+// is destroyed (on any thread) - if the pool runs dry, buffers are allocated
+// on the heap instead and freed on release
+
+class BufferPool
+{
+    struct Block
+    {
+        BufferPool *pool;
+        char *data;
+        int size;
+        QAtomicInt ref;
+        QAtomicInteger<quint32> next;
+    };
+
+public:
+
+    class Buffer
+    {
+    public:
+
+        Buffer();
+        Buffer(const Buffer &other);
+        Buffer &operator=(const Buffer &other);
+        ~Buffer();
+
+        bool isNull() const;
+        char *data() const;
+
+        int size() const;
+        void setSize(int size);
+
+        // The array refers to the buffer and is only valid while it is held
+        QByteArray toByteArray() const;
+
+    private:
+
+        friend class BufferPool;
+
+        explicit Buffer(Block *block);
+        void release();
+
+        Block *block;
+    };
+
+    BufferPool(int bufferSize, int count);
+    virtual ~BufferPool();
+
+    Buffer acquire();
+
+private:
+
+    BufferPool(const BufferPool &);
+    BufferPool &operator=(const BufferPool &);
+
+    void recycle(Block *block);
+
+    const int bufferSize;
+    const int count;
+    char *slab;
+    Block *blocks;
+
+    // The low half holds the index of the first free block plus one (zero if
+    // the list is empty) and the high half a counter that guards against ABA
+    QAtomicInteger<quint64> freeHead;
+};
+
+}
+
+#endif // QMDNSENGINE_BUFFERPOOL_P_H
@@ -30,16 +30,28 @@
 
 #include <qmdnsengine/cache.h>
 #include <qmdnsengine/dns.h>
+#include <qmdnsengine/statistics.h>
 
 #include "cache_p.h"
 
 using namespace QMdnsEngine;
 
+// Names of the counters in CachePrivate::Counter
+static const char *const CounterNames[] = {
+    "lookup_hits",
+    "lookup_misses",
+    "records_added",
+    "records_expired",
+    "refresh_requests"
+};
+
 CachePrivate::CachePrivate(Cache *cache)
     : QObject(cache),
+      counters(CounterNames, CounterCount),
+      nextTrigger(-1),
       q(cache)
 {
-    connect(&timer, &QTimer::timeout, this, &CachePrivate::onTimeout);
+    connect(&timer, &Timer::timeout, this, &CachePrivate::onTimeout);
 
     timer.setSingleShot(true);
 }
@@ -49,8 +61,8 @@ void CachePrivate::onTimeout()
     // Loop through all of the records in the cache, emitting the appropriate
     // signal when a trigger has passed, determining when the next trigger
     // will occur, and removing records that have expired
-    QDateTime now = QDateTime::currentDateTime();
-    QDateTime newNextTrigger;
+    qint64 now = currentTime(clock);
+    qint64 newNextTrigger = -1;
 
     for (auto i = entries.begin(); i != entries.end();) {
 
@@ -69,14 +81,16 @@ void CachePrivate::onTimeout()
         // If triggers remain, determine the next earliest one; if none
         // remain, the record has expired and should be removed
         if (i->triggers.length()) {
-            if (newNextTrigger.isNull() || i->triggers.at(0) < newNextTrigger) {
+            if (newNextTrigger == -1 || i->triggers.at(0) < newNextTrigger) {
                 newNextTrigger = i->triggers.at(0);
             }
             if (shouldQuery) {
+                counters.add(RefreshRequests);
                 emit q->shouldQuery(i->record);
             }
             ++i;
         } else {
+            counters.add(RecordsExpired);
             emit q->recordExpired(i->record);
             i = entries.erase(i);
         }
@@ -85,8 +99,8 @@ void CachePrivate::onTimeout()
     // If newNextTrigger contains a value, it will be the time for the next
     // trigger and the timer should be started again
     nextTrigger = newNextTrigger;
-    if (!nextTrigger.isNull()) {
-        timer.start(now.msecsTo(nextTrigger));
+    if (nextTrigger != -1) {
+        timer.start(nextTrigger - now);
     }
 }
 
@@ -96,6 +110,12 @@ Cache::Cache(QObject *parent)
 {
 }
 
+void Cache::setClock(AbstractClock *clock)
+{
+    d->clock = clock;
+    d->timer.setClock(clock);
+}
+
 void Cache::addRecord(const Record &record)
 {
     // If a record exists that matches, remove it from the cache; if the TTL
@@ -108,6 +128,7 @@ void Cache::addRecord(const Record &record)
 
             // If the TTL is set to 0, indicate that the record was removed
             if (record.ttl() == 0) {
+                d->counters.add(CachePrivate::RecordsExpired);
                 emit recordExpired((*i).record);
             }
 
@@ -123,29 +144,31 @@ void Cache::addRecord(const Record &record)
     }
 
     // Use the current time to calculate the triggers and add a random offset
-    QDateTime now = QDateTime::currentDateTime();
+    qint64 now = currentTime(d->clock);
 #ifdef USE_QRANDOMGENERATOR
     qint64 random = QRandomGenerator::global()->bounded(20);
 #else
     qint64 random = qrand() % 20;
 #endif
 
-    QList<QDateTime> triggers{
-        now.addMSecs(record.ttl() * 500 + random),  // 50%
-        now.addMSecs(record.ttl() * 850 + random),  // 85%
-        now.addMSecs(record.ttl() * 900 + random),  // 90%
-        now.addMSecs(record.ttl() * 950 + random),  // 95%
-        now.addSecs(record.ttl())
+    qint64 ttl = record.ttl();
+    QList<qint64> triggers{
+        now + ttl * 500 + random,  // 50%
+        now + ttl * 850 + random,  // 85%
+        now + ttl * 900 + random,  // 90%
+        now + ttl * 950 + random,  // 95%
+        now + ttl * 1000
     };
 
     // Append the record and its triggers
     d->entries.append({record, triggers});
+    d->counters.add(CachePrivate::RecordsAdded);
 
     // Check if the new record's first trigger is earlier than the next
     // scheduled trigger; if so, restart the timer
-    if (d->nextTrigger.isNull() || triggers.at(0) < d->nextTrigger) {
+    if (d->nextTrigger == -1 || triggers.at(0) < d->nextTrigger) {
         d->nextTrigger = triggers.at(0);
-        d->timer.start(now.msecsTo(d->nextTrigger));
+        d->timer.start(d->nextTrigger - now);
     }
 }
 
@@ -169,5 +192,28 @@ bool Cache::lookupRecords(const QByteArray &name, quint16 type, QList<Record> &r
             recordsAdded = true;
         }
     }
+    d->counters.add(recordsAdded ? CachePrivate::LookupHits : CachePrivate::LookupMisses);
     return recordsAdded;
 }
+
+bool Cache::lookupRecords(const QByteArray &name, quint16 type, QList<Record> &records,
+                          QList<qint64> &remaining) const
+{
+    qint64 now = currentTime(d->clock);
+    bool recordsAdded = false;
+    for (const CachePrivate::Entry &entry : d->entries) {
+        if ((name.isNull() || entry.record.name() == name) &&
+                (type == ANY || entry.record.type() == type)) {
+            records.append(entry.record);
+            remaining.append(qMax(entry.triggers.last() - now, static_cast<qint64>(0)));
+            recordsAdded = true;
+        }
+    }
+    d->counters.add(recordsAdded ? CachePrivate::LookupHits : CachePrivate::LookupMisses);
+    return recordsAdded;
+}
+
+Statistics Cache::statistics() const
+{
+    return d->counters.statistics();
+}
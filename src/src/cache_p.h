@@ -25,13 +25,16 @@
 #ifndef QMDNSENGINE_CACHE_P_H
 #define QMDNSENGINE_CACHE_P_H
 
-#include <QDateTime>
 #include <QList>
 #include <QObject>
-#include <QTimer>
+#include <QPointer>
 
+#include <qmdnsengine/abstractclock.h>
 #include <qmdnsengine/record.h>
 
+#include "counters_p.h"
+#include "timer_p.h"
+
 namespace QMdnsEngine
 {
 
@@ -46,14 +49,27 @@ public:
     struct Entry
     {
         Record record;
-        QList<QDateTime> triggers;
+        QList<qint64> triggers;
+    };
+
+    enum Counter {
+        LookupHits,
+        LookupMisses,
+        RecordsAdded,
+        RecordsExpired,
+        RefreshRequests,
+        CounterCount
     };
 
     CachePrivate(Cache *cache);
 
-    QTimer timer;
+    QPointer<AbstractClock> clock;
+    Timer timer;
     QList<Entry> entries;
-    QDateTime nextTrigger;
+    Counters counters;
+
+    // Time of the next trigger or -1 if there are no entries
+    qint64 nextTrigger;
 
 private Q_SLOTS:
 
@@ -0,0 +1,66 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_COUNTERS_P_H
+#define QMDNSENGINE_COUNTERS_P_H
+
+#include <QAtomicInteger>
+
+#include <qmdnsengine/statistics.h>
+
+namespace QMdnsEngine
+{
+
+// Fixed set of counters that can be incremented from any thread without
+// locking; names is a static array with an entry for each counter
+
+class Counters
+{
+public:
+
+    Counters(const char *const *names, int count);
+    virtual ~Counters();
+
+    // Defined here so that incrementing a counter is inlined on hot paths
+    void add(int index, quint64 amount = 1)
+    {
+        values[index].fetchAndAddRelaxed(amount);
+    }
+
+    quint64 value(int index) const;
+    Statistics statistics() const;
+
+private:
+
+    Counters(const Counters &);
+    Counters &operator=(const Counters &);
+
+    const char *const *const names;
+    const int count;
+    QAtomicInteger<quint64> *const values;
+};
+
+}
+
+#endif // QMDNSENGINE_COUNTERS_P_H
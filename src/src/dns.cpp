@@ -310,6 +310,7 @@ bool fromPacket(const QByteArray &packet, Message &message)
     message.setTransactionId(transactionId);
     message.setResponse(flags & 0x8400);
     message.setTruncated(flags & 0x0200);
+    message.setAuthorityCount(nAuthority);
     for (int i = 0; i < nQuestion; ++i) {
         QByteArray name;
         quint16 type, class_;
@@ -343,8 +344,8 @@ void toPacket(const Message &message, QByteArray &packet)
     writeInteger<quint16>(packet, offset, message.transactionId());
     writeInteger<quint16>(packet, offset, flags);
     writeInteger<quint16>(packet, offset, message.queries().length());
-    writeInteger<quint16>(packet, offset, message.records().length());
-    writeInteger<quint16>(packet, offset, 0);
+    writeInteger<quint16>(packet, offset, message.records().length() - message.authorityCount());
+    writeInteger<quint16>(packet, offset, message.authorityCount());
     writeInteger<quint16>(packet, offset, 0);
     QMap<QByteArray, quint16> nameMap;
     const auto queries = message.queries();
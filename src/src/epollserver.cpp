@@ -0,0 +1,365 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cerrno>
+#include <cstring>
+
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include <QNetworkInterface>
+#include <QSocketNotifier>
+
+#include <qmdnsengine/epollserver.h>
+#include <qmdnsengine/mdns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/preparedmessage.h>
+#include <qmdnsengine/statistics.h>
+
+#include "epollserver_p.h"
+#include "socketutil_p.h"
+
+using namespace QMdnsEngine;
+
+// Number of events retrieved with a single call to epoll_wait()
+const int MaxEvents = 8;
+
+// Interval for polling the interfaces when rtnetlink is not available
+const int PollInterval = 60 * 1000;
+
+// Time to wait for a burst of interface changes to settle
+const int SettleInterval = 250;
+
+EpollServerPrivate::EpollServerPrivate(EpollServer *server, EpollServer::DispatchMode mode)
+    : ServerBase(server, MessagesCoalesced, server),
+      epollFd(-1),
+      timerFd(-1),
+      netlinkFd(-1),
+      ipv4Fd(-1),
+      ipv6Fd(-1),
+      notifier(nullptr)
+{
+    // The timer is used both for polling the interfaces and for waiting for
+    // rtnetlink notifications to settle
+
+    epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (epollFd == -1) {
+        return;
+    }
+    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerFd != -1 && !watch(timerFd)) {
+        ::close(timerFd);
+        timerFd = -1;
+    }
+
+    openNetlink();
+    updateSockets();
+
+    if (mode == EpollServer::EventLoopDispatch) {
+        notifier = new QSocketNotifier(epollFd, QSocketNotifier::Read, this);
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+        connect(notifier, &QSocketNotifier::activated, this, &EpollServerPrivate::onActivated);
+#else
+        // Qt 5.15 overloads activated(), which rules out a member pointer
+        connect(notifier, SIGNAL(activated(int)), this, SLOT(onActivated()));
+#endif
+    }
+}
+
+EpollServerPrivate::~EpollServerPrivate()
+{
+    // Closing the sockets also leaves the multicast groups
+    delete notifier;
+    const int fds[] = {ipv4Fd, ipv6Fd, netlinkFd, timerFd, epollFd};
+    for (int fd : fds) {
+        if (fd != -1) {
+            ::close(fd);
+        }
+    }
+}
+
+int EpollServerPrivate::processEvents(int msec)
+{
+    if (epollFd == -1) {
+        return -1;
+    }
+
+    epoll_event events[MaxEvents];
+    int count = epoll_wait(epollFd, events, MaxEvents, msec);
+    if (count == -1) {
+        if (errno == EINTR) {
+            return 0;
+        }
+        reportError(strerror(errno));
+        return -1;
+    }
+
+    // Any replies sent while the events are being handled are held until all
+    // of them have been handled so that they can be sent together
+    deferWrites = true;
+
+    for (int i = 0; i < count; ++i) {
+        int fd = events[i].data.fd;
+        if (fd == ipv4Fd || fd == ipv6Fd) {
+            readDatagrams(fd);
+        } else if (fd == netlinkFd) {
+
+            // The contents of the notifications are not needed since the
+            // interfaces are enumerated again, so simply drain the socket
+            char buffer[4096];
+            while (::recv(netlinkFd, buffer, sizeof(buffer), 0) > 0) {}
+            armTimer(SettleInterval);
+
+        } else if (fd == timerFd) {
+            quint64 expirations;
+            if (::read(timerFd, &expirations, sizeof(expirations)) > 0) {
+                updateSockets();
+            }
+        }
+    }
+
+    deferWrites = false;
+    flushDatagrams();
+
+    return count;
+}
+
+bool EpollServerPrivate::watch(int fd)
+{
+    epoll_event event;
+    memset(&event, 0, sizeof(epoll_event));
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    return !epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+}
+
+void EpollServerPrivate::armTimer(int msec)
+{
+    if (timerFd == -1) {
+        return;
+    }
+    itimerspec spec;
+    memset(&spec, 0, sizeof(itimerspec));
+    spec.it_value.tv_sec = msec / 1000;
+    spec.it_value.tv_nsec = (msec % 1000) * 1000000;
+    timerfd_settime(timerFd, 0, &spec, nullptr);
+}
+
+void EpollServerPrivate::openNetlink()
+{
+    // Subscribe to rtnetlink notifications for links and addresses so that
+    // changes are noticed as they happen
+
+    netlinkFd = ::socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (netlinkFd == -1) {
+        return;
+    }
+
+    sockaddr_nl address;
+    memset(&address, 0, sizeof(sockaddr_nl));
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+    if (::bind(netlinkFd, reinterpret_cast<sockaddr*>(&address), sizeof(sockaddr_nl)) || !watch(netlinkFd)) {
+        ::close(netlinkFd);
+        netlinkFd = -1;
+    }
+}
+
+int EpollServerPrivate::openSocket(int family)
+{
+    // Create a non-blocking socket bound to the mDNS port that reports the
+    // interface each datagram arrived on; the port is shared with any other
+    // responders on the host
+
+    int fd = ::socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd == -1) {
+        reportError(strerror(errno));
+        return -1;
+    }
+
+    int arg = 1;
+    int hops = 255;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &arg, sizeof(int));
+#ifdef SO_REUSEPORT
+    setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &arg, sizeof(int));
+#endif
+
+    sockaddr_storage storage;
+    socklen_t length;
+    if (family == AF_INET) {
+        setsockopt(fd, IPPROTO_IP, IP_PKTINFO, &arg, sizeof(int));
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &hops, sizeof(int));
+        setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &arg, sizeof(int));
+        length = toSockaddr(QHostAddress(QHostAddress::AnyIPv4), MdnsPort, storage);
+    } else {
+        setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &arg, sizeof(int));
+        setsockopt(fd, IPPROTO_IPV6, IPV6_RECVPKTINFO, &arg, sizeof(int));
+        setsockopt(fd, IPPROTO_IPV6, IPV6_MULTICAST_HOPS, &hops, sizeof(int));
+        setsockopt(fd, IPPROTO_IPV6, IPV6_MULTICAST_LOOP, &arg, sizeof(int));
+        length = toSockaddr(QHostAddress(QHostAddress::AnyIPv6), MdnsPort, storage);
+    }
+
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&storage), length) || !watch(fd)) {
+        reportError(strerror(errno));
+        ::close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+void EpollServerPrivate::updateSockets()
+{
+    // The sockets are bound - if this fails, another attempt is made when the
+    // timer next expires - and the interfaces are updated; when rtnetlink is
+    // not available, the interfaces are polled instead
+
+    if (ipv4Fd == -1) {
+        ipv4Fd = openSocket(AF_INET);
+    }
+    if (ipv6Fd == -1) {
+        ipv6Fd = openSocket(AF_INET6);
+    }
+
+    if (ipv4Fd != -1 || ipv6Fd != -1) {
+        updateInterfaces(ipv4Fd != -1, ipv6Fd != -1);
+    }
+
+    if (netlinkFd == -1 || ipv4Fd == -1 || ipv6Fd == -1) {
+        armTimer(PollInterval);
+    }
+}
+
+bool EpollServerPrivate::setMembership(Family family, const QNetworkInterface &networkInterface, bool join)
+{
+    if (family == Ipv4Family) {
+        ip_mreqn request;
+        memset(&request, 0, sizeof(ip_mreqn));
+        request.imr_multiaddr.s_addr = htonl(MdnsIpv4Address.toIPv4Address());
+        request.imr_ifindex = networkInterface.index();
+        return !setsockopt(ipv4Fd, IPPROTO_IP, join ? IP_ADD_MEMBERSHIP : IP_DROP_MEMBERSHIP,
+                           &request, sizeof(ip_mreqn));
+    } else {
+        ipv6_mreq request;
+        memset(&request, 0, sizeof(ipv6_mreq));
+        Q_IPV6ADDR address = MdnsIpv6Address.toIPv6Address();
+        memcpy(&request.ipv6mr_multiaddr, &address, sizeof(Q_IPV6ADDR));
+        request.ipv6mr_interface = networkInterface.index();
+        return !setsockopt(ipv6Fd, IPPROTO_IPV6, join ? IPV6_JOIN_GROUP : IPV6_LEAVE_GROUP,
+                           &request, sizeof(ipv6_mreq));
+    }
+}
+
+void EpollServerPrivate::readDatagrams(int fd)
+{
+    // Drain the socket with recvmmsg(), receiving up to BatchSize datagrams
+    // per call
+    int count;
+    do {
+        count = receiveDatagrams(fd);
+        if (count == -1 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+            reportError(strerror(errno));
+        }
+    } while (count == BatchSize);
+}
+
+void EpollServerPrivate::writeDatagrams(Family family, QList<Datagram> &datagrams)
+{
+    int fd = family == Ipv4Family ? ipv4Fd : ipv6Fd;
+    if (fd == -1) {
+        datagrams.clear();
+    } else {
+        sendDatagrams(fd, datagrams);
+    }
+}
+
+void EpollServerPrivate::onActivated()
+{
+    processEvents(0);
+}
+
+EpollServer::EpollServer(QObject *parent)
+    : AbstractServer(parent),
+      d(new EpollServerPrivate(this, EventLoopDispatch))
+{
+}
+
+EpollServer::EpollServer(DispatchMode mode, QObject *parent)
+    : AbstractServer(parent),
+      d(new EpollServerPrivate(this, mode))
+{
+}
+
+EpollServer::~EpollServer()
+{
+}
+
+int EpollServer::descriptor() const
+{
+    return d->epollFd;
+}
+
+int EpollServer::processEvents(int msec)
+{
+    return d->processEvents(msec);
+}
+
+Statistics EpollServer::statistics() const
+{
+    return d->counters.statistics();
+}
+
+void EpollServer::sendMessage(const Message &message)
+{
+    d->writeMessage(message, false, QByteArray());
+}
+
+void EpollServer::sendMessageToAll(const Message &message)
+{
+    d->writeMessage(message, true, QByteArray());
+}
+
+void EpollServer::sendPreparedMessage(const PreparedMessage &message)
+{
+    d->writeMessage(message.message(), false, message.packet());
+}
+
+void EpollServer::sendPreparedMessageToAll(const PreparedMessage &message)
+{
+    d->writeMessage(message.message(), true, message.packet());
+}
+
+QList<QNetworkAddressEntry> EpollServer::addressEntries(int interfaceIndex) const
+{
+    return d->addressEntries(interfaceIndex);
+}
+
+QList<int> EpollServer::interfaceIndices() const
+{
+    return d->interfaceIndices();
+}
@@ -0,0 +1,77 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_EPOLLSERVER_P_H
+#define QMDNSENGINE_EPOLLSERVER_P_H
+
+#include <QList>
+#include <QNetworkInterface>
+#include <QObject>
+
+#include <qmdnsengine/epollserver.h>
+
+#include "serverbase_p.h"
+
+class QSocketNotifier;
+
+namespace QMdnsEngine
+{
+
+class EpollServerPrivate : public ServerBase
+{
+    Q_OBJECT
+
+public:
+
+    EpollServerPrivate(EpollServer *server, EpollServer::DispatchMode mode);
+    virtual ~EpollServerPrivate();
+
+    int processEvents(int msec);
+
+    bool watch(int fd);
+    void armTimer(int msec);
+    void openNetlink();
+    int openSocket(int family);
+    void updateSockets();
+
+    void readDatagrams(int fd);
+
+    virtual bool setMembership(Family family, const QNetworkInterface &networkInterface, bool join);
+    virtual void writeDatagrams(Family family, QList<Datagram> &datagrams);
+
+    int epollFd;
+    int timerFd;
+    int netlinkFd;
+    int ipv4Fd;
+    int ipv6Fd;
+    QSocketNotifier *notifier;
+
+private Q_SLOTS:
+
+    void onActivated();
+};
+
+}
+
+#endif // QMDNSENGINE_EPOLLSERVER_P_H
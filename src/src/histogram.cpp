@@ -0,0 +1,210 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cmath>
+
+#include <qmdnsengine/histogram.h>
+
+#include "histogram_p.h"
+
+using namespace QMdnsEngine;
+
+HistogramPrivate::HistogramPrivate()
+    : count(0),
+      minimum(0),
+      maximum(0),
+      sum(0)
+{
+}
+
+int HistogramPrivate::bucketIndex(qint64 value)
+{
+    if (value < SubBucketCount) {
+        return static_cast<int>(value);
+    }
+
+    // Shift the value until it falls in the upper half of the sub-buckets
+    int shift = 0;
+    while ((value >> shift) >= SubBucketCount) {
+        ++shift;
+    }
+    return SubBucketCount + (shift - 1) * SubBucketHalf +
+            static_cast<int>(value >> shift) - SubBucketHalf;
+}
+
+qint64 HistogramPrivate::bucketLowest(int index)
+{
+    if (index < SubBucketCount) {
+        return index;
+    }
+    int shift = (index - SubBucketCount) / SubBucketHalf + 1;
+    qint64 subBucket = (index - SubBucketCount) % SubBucketHalf + SubBucketHalf;
+    return subBucket << shift;
+}
+
+qint64 HistogramPrivate::bucketHighest(int index)
+{
+    if (index < SubBucketCount) {
+        return index;
+    }
+    int shift = (index - SubBucketCount) / SubBucketHalf + 1;
+    return bucketLowest(index) + (static_cast<qint64>(1) << shift) - 1;
+}
+
+void HistogramPrivate::add(int index, quint64 amount)
+{
+    if (index >= buckets.size()) {
+        buckets.resize(index + 1);
+    }
+    buckets[index] += amount;
+}
+
+Histogram::Histogram()
+    : d(new HistogramPrivate)
+{
+}
+
+Histogram::Histogram(const Histogram &other)
+    : d(new HistogramPrivate)
+{
+    *this = other;
+}
+
+Histogram &Histogram::operator=(const Histogram &other)
+{
+    *d = *other.d;
+    return *this;
+}
+
+Histogram::~Histogram()
+{
+    delete d;
+}
+
+void Histogram::record(qint64 value)
+{
+    if (value < 0) {
+        value = 0;
+    }
+    d->add(HistogramPrivate::bucketIndex(value), 1);
+    if (!d->count || value < d->minimum) {
+        d->minimum = value;
+    }
+    if (!d->count || value > d->maximum) {
+        d->maximum = value;
+    }
+    ++d->count;
+    d->sum += value;
+}
+
+quint64 Histogram::count() const
+{
+    return d->count;
+}
+
+qint64 Histogram::minimum() const
+{
+    return d->minimum;
+}
+
+qint64 Histogram::maximum() const
+{
+    return d->maximum;
+}
+
+qint64 Histogram::sum() const
+{
+    return d->sum;
+}
+
+double Histogram::mean() const
+{
+    return d->count ? static_cast<double>(d->sum) / d->count : 0;
+}
+
+qint64 Histogram::percentile(double percentile) const
+{
+    if (!d->count) {
+        return 0;
+    }
+    if (percentile <= 0) {
+        return d->minimum;
+    }
+
+    // Find the bucket containing the value with the requested rank
+    quint64 rank = static_cast<quint64>(std::ceil(percentile / 100 * d->count));
+    rank = qBound<quint64>(1, rank, d->count);
+    quint64 total = 0;
+    for (int i = 0; i < d->buckets.size(); ++i) {
+        total += d->buckets.at(i);
+        if (total >= rank) {
+            return qMin(HistogramPrivate::bucketHighest(i), d->maximum);
+        }
+    }
+    return d->maximum;
+}
+
+Histogram &Histogram::operator+=(const Histogram &other)
+{
+    if (!other.d->count) {
+        return *this;
+    }
+    for (int i = 0; i < other.d->buckets.size(); ++i) {
+        if (other.d->buckets.at(i)) {
+            d->add(i, other.d->buckets.at(i));
+        }
+    }
+    if (!d->count || other.d->minimum < d->minimum) {
+        d->minimum = other.d->minimum;
+    }
+    if (!d->count || other.d->maximum > d->maximum) {
+        d->maximum = other.d->maximum;
+    }
+    d->count += other.d->count;
+    d->sum += other.d->sum;
+    return *this;
+}
+
+QByteArray Histogram::toPrometheus(const QByteArray &name) const
+{
+    static const struct {
+        const char *label;
+        double percentile;
+    } quantiles[] = {
+        {"0.5", 50},
+        {"0.9", 90},
+        {"0.99", 99},
+        {"0.999", 99.9}
+    };
+
+    QByteArray output;
+    output.append("# TYPE " + name + " summary\n");
+    for (const auto &quantile : quantiles) {
+        QByteArray value = QByteArray::number(percentile(quantile.percentile));
+        output.append(name + "{quantile=\"" + quantile.label + "\"} " + value + "\n");
+    }
+    output.append(name + "_sum " + QByteArray::number(d->sum) + "\n");
+    output.append(name + "_count " + QByteArray::number(d->count) + "\n");
+    return output;
+}
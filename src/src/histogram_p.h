@@ -0,0 +1,62 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_HISTOGRAM_P_H
+#define QMDNSENGINE_HISTOGRAM_P_H
+
+#include <QVector>
+
+namespace QMdnsEngine
+{
+
+class HistogramPrivate
+{
+public:
+
+    HistogramPrivate();
+
+    // Values below SubBucketCount each have a bucket of their own; above
+    // that, each power of two is split into SubBucketCount / 2 buckets
+    enum {
+        SubBucketBits = 7,
+        SubBucketCount = 1 << SubBucketBits,
+        SubBucketHalf = SubBucketCount / 2
+    };
+
+    static int bucketIndex(qint64 value);
+    static qint64 bucketLowest(int index);
+    static qint64 bucketHighest(int index);
+
+    void add(int index, quint64 amount);
+
+    QVector<quint64> buckets;
+    quint64 count;
+    qint64 minimum;
+    qint64 maximum;
+    qint64 sum;
+};
+
+}
+
+#endif // QMDNSENGINE_HISTOGRAM_P_H
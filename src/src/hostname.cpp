@@ -43,9 +43,18 @@ HostnamePrivate::HostnamePrivate(Hostname *hostname, AbstractServer *server)
       server(server),
       q(hostname)
 {
-    connect(server, &AbstractServer::messageReceived, this, &HostnamePrivate::onMessageReceived);
-    connect(&registrationTimer, &QTimer::timeout, this, &HostnamePrivate::onRegistrationTimeout);
-    connect(&rebroadcastTimer, &QTimer::timeout, this, &HostnamePrivate::onRebroadcastTimeout);
+    server->setMessageHandler(this, [this](const Message &message) {
+        onMessageReceived(message);
+    });
+    registrationTimer.setClock(server->clock());
+    rebroadcastTimer.setClock(server->clock());
+    connect(&registrationTimer, &Timer::timeout, this, &HostnamePrivate::onRegistrationTimeout);
+    connect(&rebroadcastTimer, &Timer::timeout, this, &HostnamePrivate::onRebroadcastTimeout);
+
+    // Announce the hostname again when the network changes, probing any new
+    // links first since they may have hosts that are using the same name
+    connect(server, &AbstractServer::interfacesChanged, this, &HostnamePrivate::onInterfacesChanged);
+    interfaces = server->interfaceIndices();
 
     registrationTimer.setInterval(2 * 1000);
     registrationTimer.setSingleShot(true);
@@ -64,12 +73,29 @@ void HostnamePrivate::assertHostname()
     QByteArray localHostname = QHostInfo::localHostName().toUtf8();
     localHostname = localHostname.replace('.', '-');
 
+    // Replace the subscriptions for the previous hostname
+    server->unsubscribe(this, hostname, A);
+    server->unsubscribe(this, hostname, AAAA);
+
     // If the suffix > 1, then append a "-2", "-3", etc. to the hostname to
     // aid in finding one that is unique and not in use
     hostname = (hostnameSuffix == 1 ? localHostname:
         localHostname + "-" + QByteArray::number(hostnameSuffix)) + ".local.";
 
-    // Compose a query for A and AAAA records matching the hostname
+    server->subscribe(this, hostname, A);
+    server->subscribe(this, hostname, AAAA);
+
+    probedInterfaces.clear();
+    probe(0);
+
+    // If no reply is received after two seconds, the hostname is available
+    registrationTimer.start();
+}
+
+void HostnamePrivate::probe(int interfaceIndex)
+{
+    // Compose a query for A and AAAA records matching the hostname, sent on
+    // every interface unless one is specified
     Query ipv4Query;
     ipv4Query.setName(hostname);
     ipv4Query.setType(A);
@@ -77,50 +103,103 @@ void HostnamePrivate::assertHostname()
     ipv6Query.setName(hostname);
     ipv6Query.setType(AAAA);
     Message message;
+    message.setInterfaceIndex(interfaceIndex);
     message.addQuery(ipv4Query);
     message.addQuery(ipv6Query);
 
     server->sendMessageToAll(message);
+}
 
-    // If no reply is received after two seconds, the hostname is available
-    registrationTimer.start();
+void HostnamePrivate::announce(const QList<int> &indices)
+{
+    // Send each interface the records for its own addresses
+    for (int index : indices) {
+        Message message;
+        message.setResponse(true);
+        message.setInterfaceIndex(index);
+        Record record;
+        if (generateRecord(QHostAddress(), index, A, record)) {
+            message.addRecord(record);
+        }
+        if (generateRecord(QHostAddress(), index, AAAA, record)) {
+            message.addRecord(record);
+        }
+        if (message.records().count()) {
+            server->sendMessageToAll(message);
+        }
+    }
+}
+
+bool HostnamePrivate::isLocalAddress(int interfaceIndex, const QHostAddress &address) const
+{
+    const auto entries = server->addressEntries(interfaceIndex);
+    for (const QNetworkAddressEntry &entry : entries) {
+        if (entry.ip() == address) {
+            return true;
+        }
+    }
+    return false;
 }
 
-bool HostnamePrivate::generateRecord(const QHostAddress &srcAddress, quint16 type, Record &record)
+QList<QNetworkAddressEntry> HostnamePrivate::subnetEntries(const QHostAddress &srcAddress) const
 {
     // Attempt to find the interface that corresponds with the provided
-    // address and determine this device's address from the interface
+    // address and return all of its addresses
 
     const auto interfaces = QNetworkInterface::allInterfaces();
     for (const QNetworkInterface &networkInterface : interfaces) {
         const auto entries = networkInterface.addressEntries();
         for (const QNetworkAddressEntry &entry : entries) {
             if (srcAddress.isInSubnet(entry.ip(), entry.prefixLength())) {
-                for (const QNetworkAddressEntry &newEntry : entries) {
-                    QHostAddress address = newEntry.ip();
-                    if ((address.protocol() == QAbstractSocket::IPv4Protocol && type == A) ||
-                            (address.protocol() == QAbstractSocket::IPv6Protocol && type == AAAA)) {
-                        record.setName(hostname);
-                        record.setType(type);
-                        record.setAddress(address);
-                        return true;
-                    }
-                }
+                return entries;
             }
         }
     }
+    return QList<QNetworkAddressEntry>();
+}
+
+bool HostnamePrivate::generateRecord(const QHostAddress &srcAddress, int interfaceIndex, quint16 type, Record &record)
+{
+    // Determine this device's address from the interface the query was
+    // received on - if that is unknown, use the source address to find it
+
+    const QList<QNetworkAddressEntry> entries = interfaceIndex ?
+        server->addressEntries(interfaceIndex) :
+        subnetEntries(srcAddress);
+    for (const QNetworkAddressEntry &entry : entries) {
+        QHostAddress address = entry.ip();
+        if ((address.protocol() == QAbstractSocket::IPv4Protocol && type == A) ||
+                (address.protocol() == QAbstractSocket::IPv6Protocol && type == AAAA)) {
+            record.setName(hostname);
+            record.setType(type);
+            record.setAddress(address);
+            return true;
+        }
+    }
     return false;
 }
 
 void HostnamePrivate::onMessageReceived(const Message &message)
 {
     if (message.isResponse()) {
-        if (hostnameRegistered) {
+
+        // Once registered, only responses from links that are being probed
+        // can indicate a conflict - and not the server's own replies there
+        bool probingLink = hostnameRegistered;
+        if (probingLink && !probedInterfaces.contains(message.interfaceIndex())) {
             return;
         }
         const auto records = message.records();
         for (const Record &record : records) {
             if ((record.type() == A || record.type() == AAAA) && record.name() == hostname) {
+                if (probingLink && isLocalAddress(message.interfaceIndex(), record.address())) {
+                    continue;
+                }
+                if (probingLink) {
+                    hostnamePrev = hostname;
+                    hostnameRegistered = false;
+                    probingLink = false;
+                }
                 ++hostnameSuffix;
                 assertHostname();
             }
@@ -135,7 +214,7 @@ void HostnamePrivate::onMessageReceived(const Message &message)
         for (const Query &query : queries) {
             if ((query.type() == A || query.type() == AAAA) && query.name() == hostname) {
                 Record record;
-                if (generateRecord(message.address(), query.type(), record)) {
+                if (generateRecord(message.address(), message.interfaceIndex(), query.type(), record)) {
                     reply.addRecord(record);
                 }
             }
@@ -148,6 +227,13 @@ void HostnamePrivate::onMessageReceived(const Message &message)
 
 void HostnamePrivate::onRegistrationTimeout()
 {
+    // Links probed after the hostname was registered can now be told of it
+    if (hostnameRegistered) {
+        announce(probedInterfaces);
+        probedInterfaces.clear();
+        return;
+    }
+
     hostnameRegistered = true;
     if (hostname != hostnamePrev) {
         emit q->hostnameChanged(hostname);
@@ -166,6 +252,39 @@ void HostnamePrivate::onRebroadcastTimeout()
     assertHostname();
 }
 
+void HostnamePrivate::onInterfacesChanged()
+{
+    // Links that were already known are simply given the records again
+    // (their addresses may have changed) while new links are probed first;
+    // while the hostname is still being registered, new links only need to
+    // see the probe
+
+    const QList<int> indices = server->interfaceIndices();
+    QList<int> known;
+    QList<int> added;
+    for (int index : indices) {
+        if (!interfaces.contains(index)) {
+            added.append(index);
+        } else if (!probedInterfaces.contains(index)) {
+            known.append(index);
+        }
+    }
+    interfaces = indices;
+
+    for (int index : added) {
+        probe(index);
+    }
+    if (!hostnameRegistered) {
+        return;
+    }
+
+    announce(known);
+    if (!added.isEmpty()) {
+        probedInterfaces.append(added);
+        registrationTimer.start();
+    }
+}
+
 Hostname::Hostname(AbstractServer *server, QObject *parent)
     : QObject(parent),
       d(new HostnamePrivate(this, server))
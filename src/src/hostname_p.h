@@ -25,10 +25,13 @@
 #ifndef QMDNSENGINE_HOSTNAME_P_H
 #define QMDNSENGINE_HOSTNAME_P_H
 
+#include <QList>
 #include <QObject>
-#include <QTimer>
+
+#include "timer_p.h"
 
 class QHostAddress;
+class QNetworkAddressEntry;
 
 namespace QMdnsEngine
 {
@@ -47,7 +50,11 @@ public:
     HostnamePrivate(Hostname *hostname, AbstractServer *server);
 
     void assertHostname();
-    bool generateRecord(const QHostAddress &srcAddress, quint16 type, Record &record);
+    void probe(int interfaceIndex);
+    void announce(const QList<int> &indices);
+    bool isLocalAddress(int interfaceIndex, const QHostAddress &address) const;
+    QList<QNetworkAddressEntry> subnetEntries(const QHostAddress &srcAddress) const;
+    bool generateRecord(const QHostAddress &srcAddress, int interfaceIndex, quint16 type, Record &record);
 
     AbstractServer *server;
 
@@ -56,14 +63,20 @@ public:
     bool hostnameRegistered;
     int hostnameSuffix;
 
-    QTimer registrationTimer;
-    QTimer rebroadcastTimer;
+    Timer registrationTimer;
+    Timer rebroadcastTimer;
+
+    // Interfaces known since the last change and those added by it that
+    // are being probed while the hostname remains registered
+    QList<int> interfaces;
+    QList<int> probedInterfaces;
 
 private Q_SLOTS:
 
     void onMessageReceived(const Message &message);
     void onRegistrationTimeout();
     void onRebroadcastTimeout();
+    void onInterfacesChanged();
 
 private:
 
@@ -0,0 +1,94 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include <qmdnsengine/cache.h>
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/message.h>
+
+#include "knownanswers_p.h"
+
+using namespace QMdnsEngine;
+
+// Size of the header at the start of every DNS message
+const int HeaderSize = 12;
+
+KnownAnswers::KnownAnswers(Cache *cache, int budget)
+    : cache(cache),
+      budget(budget)
+{
+}
+
+void KnownAnswers::add(const QByteArray &name, quint16 type)
+{
+    QList<Record> records;
+    QList<qint64> remaining;
+    cache->lookupRecords(name, type, records, remaining);
+
+    for (int i = 0; i < records.count(); ++i) {
+
+        // Records past the halfway point of their lifetime are left out so
+        // that responders refresh them
+        Record record = records.at(i);
+        if (remaining.at(i) * 2 <= static_cast<qint64>(record.ttl()) * 1000) {
+            continue;
+        }
+
+        // Responders compare the TTL of known answers with the true TTL, so
+        // report the time that is actually left
+        record.setTtl(static_cast<quint32>(remaining.at(i) / 1000));
+        answers.append({record, remaining.at(i)});
+    }
+}
+
+int KnownAnswers::addTo(Message &message) const
+{
+    QList<Answer> sorted = answers;
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Answer &a, const Answer &b) {
+        return a.remaining > b.remaining;
+    });
+
+    QByteArray packet;
+    toPacket(message, packet);
+    int size = packet.size();
+
+    // Each record is measured on its own, which (without name compression
+    // against the rest of the message) slightly overestimates its size
+    int omitted = 0;
+    for (const Answer &answer : sorted) {
+        Message single;
+        single.addRecord(answer.record);
+        QByteArray singlePacket;
+        toPacket(single, singlePacket);
+        int recordSize = singlePacket.size() - HeaderSize;
+        if (size + recordSize > budget) {
+            ++omitted;
+            continue;
+        }
+        message.addRecord(answer.record);
+        size += recordSize;
+    }
+    return omitted;
+}
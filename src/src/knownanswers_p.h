@@ -0,0 +1,76 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_KNOWNANSWERS_P_H
+#define QMDNSENGINE_KNOWNANSWERS_P_H
+
+#include <QByteArray>
+#include <QList>
+
+#include <qmdnsengine/record.h>
+
+namespace QMdnsEngine
+{
+
+class Cache;
+class Message;
+
+// Builds the known-answer section of a query (RFC 6762 section 7.1) from
+// the records in a cache; only records with more than half of their TTL
+// remaining are included, longest-lived first, for as long as they fit in
+// the packet budget
+
+class KnownAnswers
+{
+public:
+
+    // Small enough to fit in a typical Ethernet frame
+    enum {
+        DefaultBudget = 1440
+    };
+
+    explicit KnownAnswers(Cache *cache, int budget = DefaultBudget);
+
+    void add(const QByteArray &name, quint16 type);
+
+    // Add the answers to the message (which should already contain its
+    // queries) and return the number left out for lack of space
+    int addTo(Message &message) const;
+
+private:
+
+    struct Answer
+    {
+        Record record;
+        qint64 remaining;
+    };
+
+    Cache *const cache;
+    const int budget;
+    QList<Answer> answers;
+};
+
+}
+
+#endif // QMDNSENGINE_KNOWNANSWERS_P_H
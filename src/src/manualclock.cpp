@@ -0,0 +1,89 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <qmdnsengine/manualclock.h>
+
+#include "manualclock_p.h"
+
+using namespace QMdnsEngine;
+
+ManualClockPrivate::ManualClockPrivate(ManualClock *clock)
+    : QObject(clock),
+      elapsed(0),
+      nextId(1)
+{
+}
+
+ManualClock::ManualClock(QObject *parent)
+    : AbstractClock(parent),
+      d(new ManualClockPrivate(this))
+{
+}
+
+qint64 ManualClock::elapsed() const
+{
+    return d->elapsed;
+}
+
+int ManualClock::schedule(qint64 msec, const Callback &callback)
+{
+    int id = d->nextId++;
+    qint64 time = d->elapsed + qMax<qint64>(0, msec);
+    d->callbacks.insert(qMakePair(time, id), callback);
+    d->times.insert(id, time);
+    return id;
+}
+
+void ManualClock::cancel(int id)
+{
+    auto i = d->times.find(id);
+    if (i != d->times.end()) {
+        d->callbacks.remove(qMakePair(i.value(), id));
+        d->times.erase(i);
+    }
+}
+
+int ManualClock::advance(qint64 msec)
+{
+    // The callback is removed before it is invoked since it may schedule or
+    // cancel others
+
+    qint64 target = d->elapsed + qMax<qint64>(0, msec);
+    int count = 0;
+    while (!d->callbacks.isEmpty() && d->callbacks.firstKey().first <= target) {
+        QPair<qint64, int> key = d->callbacks.firstKey();
+        Callback callback = d->callbacks.take(key);
+        d->times.remove(key.second);
+        d->elapsed = key.first;
+        callback();
+        ++count;
+    }
+    d->elapsed = target;
+    return count;
+}
+
+qint64 ManualClock::remainingTime() const
+{
+    return d->callbacks.isEmpty() ? -1 : d->callbacks.firstKey().first - d->elapsed;
+}
@@ -33,9 +33,11 @@ using namespace QMdnsEngine;
 
 MessagePrivate::MessagePrivate()
     : port(0),
+      interfaceIndex(0),
       transactionId(0),
       isResponse(false),
-      isTruncated(false)
+      isTruncated(false),
+      authorityCount(0)
 {
 }
 
@@ -81,6 +83,16 @@ void Message::setPort(quint16 port)
     d->port = port;
 }
 
+int Message::interfaceIndex() const
+{
+    return d->interfaceIndex;
+}
+
+void Message::setInterfaceIndex(int interfaceIndex)
+{
+    d->interfaceIndex = interfaceIndex;
+}
+
 quint16 Message::transactionId() const
 {
     return d->transactionId;
@@ -131,6 +143,16 @@ void Message::addRecord(const Record &record)
     d->records.append(record);
 }
 
+int Message::authorityCount() const
+{
+    return d->authorityCount;
+}
+
+void Message::setAuthorityCount(int authorityCount)
+{
+    d->authorityCount = authorityCount;
+}
+
 void Message::reply(const Message &other)
 {
     if (other.port() == MdnsPort) {
@@ -143,6 +165,7 @@ void Message::reply(const Message &other)
         setAddress(other.address());
     }
     setPort(other.port());
+    setInterfaceIndex(other.interfaceIndex());
     setTransactionId(other.transactionId());
     setResponse(true);
 }
@@ -42,11 +42,13 @@ public:
 
     QHostAddress address;
     quint16 port;
+    int interfaceIndex;
     quint16 transactionId;
     bool isResponse;
     bool isTruncated;
     QList<Query> queries;
     QList<Record> records;
+    int authorityCount;
 };
 
 }
@@ -0,0 +1,90 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/preparedmessage.h>
+
+#include "preparedmessage_p.h"
+
+using namespace QMdnsEngine;
+
+PreparedMessage::PreparedMessage()
+    : d(new PreparedMessagePrivate)
+{
+}
+
+PreparedMessage::PreparedMessage(const Message &message)
+    : d(new PreparedMessagePrivate)
+{
+    d->message = message;
+    toPacket(message, d->packet);
+}
+
+PreparedMessage::PreparedMessage(const PreparedMessage &other)
+    : d(new PreparedMessagePrivate)
+{
+    *this = other;
+}
+
+PreparedMessage &PreparedMessage::operator=(const PreparedMessage &other)
+{
+    *d = *other.d;
+    return *this;
+}
+
+PreparedMessage::~PreparedMessage()
+{
+    delete d;
+}
+
+bool PreparedMessage::isNull() const
+{
+    return d->packet.isNull();
+}
+
+Message PreparedMessage::message() const
+{
+    return d->message;
+}
+
+QByteArray PreparedMessage::packet() const
+{
+    return d->packet;
+}
+
+void PreparedMessage::setAddress(const QHostAddress &address)
+{
+    d->message.setAddress(address);
+}
+
+void PreparedMessage::setPort(quint16 port)
+{
+    d->message.setPort(port);
+}
+
+void PreparedMessage::setInterfaceIndex(int interfaceIndex)
+{
+    d->message.setInterfaceIndex(interfaceIndex);
+}
@@ -45,8 +45,11 @@ ProberPrivate::ProberPrivate(Prober *prober, AbstractServer *server, const Recor
     name = record.name().left(index);
     type = record.name().mid(index);
 
-    connect(server, &AbstractServer::messageReceived, this, &ProberPrivate::onMessageReceived);
-    connect(&timer, &QTimer::timeout, this, &ProberPrivate::onTimeout);
+    server->setMessageHandler(this, [this](const Message &message) {
+        onMessageReceived(message);
+    });
+    timer.setClock(server->clock());
+    connect(&timer, &Timer::timeout, this, &ProberPrivate::onTimeout);
 
     timer.setSingleShot(true);
 
@@ -55,21 +58,26 @@ ProberPrivate::ProberPrivate(Prober *prober, AbstractServer *server, const Recor
 
 void ProberPrivate::assertRecord()
 {
+    // Replace the subscription for the previous name
+    server->unsubscribe(this, proposedRecord.name(), proposedRecord.type());
+
 	// Use the current suffix to set the name of the proposed record
 	QString tmpName = suffix == 1
 						  ? QString("%1%2").arg(name, type.constData())
 						  : QString("%1-%2%3").arg(name.constData(), QByteArray::number(suffix), type);
 
 	proposedRecord.setName(tmpName.toUtf8());
+    server->subscribe(this, proposedRecord.name(), proposedRecord.type());
 
     // Broadcast a query for the proposed name (using an ANY query) and
-    // include the proposed record in the query
+    // include the proposed record in the authority section
     Query query;
     query.setName(proposedRecord.name());
     query.setType(ANY);
     Message message;
     message.addQuery(query);
     message.addRecord(proposedRecord);
+    message.setAuthorityCount(1);
     server->sendMessageToAll(message);
 
     // Wait two seconds to confirm it is unique
@@ -97,6 +105,7 @@ void ProberPrivate::onMessageReceived(const Message &message)
 void ProberPrivate::onTimeout()
 {
     confirmed = true;
+    server->unsubscribeAll(this);
     emit q->nameConfirmed(proposedRecord.name());
 }
 
@@ -26,10 +26,11 @@
 #define QMDNSENGINE_PROBER_P_H
 
 #include <QObject>
-#include <QTimer>
 
 #include <qmdnsengine/record.h>
 
+#include "timer_p.h"
+
 namespace QMdnsEngine
 {
 
@@ -48,7 +49,7 @@ public:
     void assertRecord();
 
     AbstractServer *server;
-    QTimer timer;
+    Timer timer;
 
     bool confirmed;
 
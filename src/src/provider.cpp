@@ -22,29 +22,70 @@
  * IN THE SOFTWARE.
  */
 
+#include <QtGlobal>
+#if(QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
+#include <QRandomGenerator>
+#define USE_QRANDOMGENERATOR
+#endif
+
 #include <qmdnsengine/abstractserver.h>
 #include <qmdnsengine/dns.h>
 #include <qmdnsengine/hostname.h>
 #include <qmdnsengine/mdns.h>
 #include <qmdnsengine/message.h>
+#include <qmdnsengine/preparedmessage.h>
 #include <qmdnsengine/prober.h>
 #include <qmdnsengine/provider.h>
 #include <qmdnsengine/query.h>
+#include <qmdnsengine/statistics.h>
 
 #include "provider_p.h"
 
 using namespace QMdnsEngine;
 
+// Records that can be included in a reply
+enum {
+    BrowsePtrRecord = 1,
+    PtrRecord = 2,
+    SrvRecord = 4,
+    TxtRecord = 8
+};
+
+// Names of the counters in ProviderPrivate::Counter
+static const char *const CounterNames[] = {
+    "queries_received",
+    "replies_sent",
+    "records_suppressed",
+    "announcements",
+    "probes",
+    "conflicts"
+};
+
+// Determine if a record multicast by another responder makes sending the
+// provided one unnecessary (RFC 6762 section 7.4)
+static bool isDuplicate(const Record &record, const Record &other)
+{
+    return record == other && record.ttl() >= other.ttl() / 2;
+}
+
 ProviderPrivate::ProviderPrivate(QObject *parent, AbstractServer *server, Hostname *hostname)
     : QObject(parent),
       server(server),
       hostname(hostname),
       prober(nullptr),
       initialized(false),
-      confirmed(false)
+      confirmed(false),
+      counters(CounterNames, CounterCount)
 {
-    connect(server, &AbstractServer::messageReceived, this, &ProviderPrivate::onMessageReceived);
+    server->setMessageHandler(this, [this](const Message &message) {
+        onMessageReceived(message);
+    });
     connect(hostname, &Hostname::hostnameChanged, this, &ProviderPrivate::onHostnameChanged);
+    connect(server, &AbstractServer::interfacesChanged, this, &ProviderPrivate::onInterfacesChanged);
+    replyTimer.setClock(server->clock());
+    connect(&replyTimer, &Timer::timeout, this, &ProviderPrivate::onReplyTimeout);
+
+    replyTimer.setSingleShot(true);
 
     browsePtrProposed.setName(MdnsBrowseType);
     browsePtrProposed.setType(PTR);
@@ -62,14 +103,19 @@ ProviderPrivate::~ProviderPrivate()
 
 void ProviderPrivate::announce()
 {
-    // Broadcast a message with each of the records
+    // Broadcast a message with each of the records, which is only serialized
+    // again when the records change
 
-    Message message;
-    message.setResponse(true);
-    message.addRecord(ptrRecord);
-    message.addRecord(srvRecord);
-    message.addRecord(txtRecord);
-    server->sendMessageToAll(message);
+    if (announcement.isNull()) {
+        Message message;
+        message.setResponse(true);
+        message.addRecord(ptrRecord);
+        message.addRecord(srvRecord);
+        message.addRecord(txtRecord);
+        announcement = PreparedMessage(message);
+    }
+    counters.add(Announcements);
+    server->sendPreparedMessageToAll(announcement);
 }
 
 void ProviderPrivate::confirm()
@@ -80,6 +126,7 @@ void ProviderPrivate::confirm()
         delete prober;
     }
     prober = new Prober(server, srvProposed, this);
+    counters.add(Probes);
     connect(prober, &Prober::nameConfirmed, [this](const QByteArray &name) {
 
         // If existing records were confirmed, indicate that they are no
@@ -91,6 +138,9 @@ void ProviderPrivate::confirm()
         }
 
         // Update the proposed records
+        if (name != srvProposed.name()) {
+            counters.add(Conflicts);
+        }
         ptrProposed.setTarget(name);
         srvProposed.setName(name);
         txtProposed.setName(name);
@@ -111,25 +161,120 @@ void ProviderPrivate::farewell()
     ptrRecord.setTtl(0);
     srvRecord.setTtl(0);
     txtRecord.setTtl(0);
+    announcement = PreparedMessage();
+    replies.clear();
+    pendingReplies.clear();
+    replyTimer.stop();
     announce();
 }
 
 void ProviderPrivate::publish()
 {
-    // Copy the proposed records over and announce them
+    // Move the subscriptions over to the proposed names, copy the proposed
+    // records over, and announce them
+
+    server->unsubscribe(this, ptrRecord.name(), PTR);
+    server->unsubscribe(this, srvRecord.name(), SRV);
+    server->unsubscribe(this, txtRecord.name(), TXT);
+    server->subscribe(this, MdnsBrowseType, PTR);
+    server->subscribe(this, ptrProposed.name(), PTR);
+    server->subscribe(this, srvProposed.name(), SRV);
+    server->subscribe(this, txtProposed.name(), TXT);
 
     browsePtrRecord = browsePtrProposed;
     ptrRecord = ptrProposed;
     srvRecord = srvProposed;
     txtRecord = txtProposed;
+    announcement = PreparedMessage();
+    replies.clear();
+    pendingReplies.clear();
+    replyTimer.stop();
     announce();
 }
 
+void ProviderPrivate::sendReply(const Message &reply, int records)
+{
+    // Replies without a transaction ID depend only on the records being
+    // sent, so they are kept for reuse until the records change
+
+    PreparedMessage prepared = reply.transactionId() ? PreparedMessage() : replies.value(records);
+    if (prepared.isNull()) {
+        Message message = reply;
+        if (records & BrowsePtrRecord) {
+            message.addRecord(browsePtrRecord);
+        }
+        if (records & PtrRecord) {
+            message.addRecord(ptrRecord);
+        }
+        if (records & SrvRecord) {
+            message.addRecord(srvRecord);
+        }
+        if (records & TxtRecord) {
+            message.addRecord(txtRecord);
+        }
+        prepared = PreparedMessage(message);
+        if (!reply.transactionId()) {
+            replies.insert(records, prepared);
+        }
+    } else {
+        prepared.setAddress(reply.address());
+        prepared.setPort(reply.port());
+        prepared.setInterfaceIndex(reply.interfaceIndex());
+    }
+    counters.add(RepliesSent);
+    server->sendPreparedMessage(prepared);
+}
+
+void ProviderPrivate::suppressReplies(const Message &message)
+{
+    // Remove any records from pending replies that another responder has
+    // just multicast on the same network
+
+    int records = 0;
+    const auto messageRecords = message.records();
+    for (const Record &record : messageRecords) {
+        if (isDuplicate(record, browsePtrRecord)) {
+            records |= BrowsePtrRecord;
+        } else if (isDuplicate(record, ptrRecord)) {
+            records |= PtrRecord;
+        } else if (isDuplicate(record, srvRecord)) {
+            records |= SrvRecord;
+        } else if (isDuplicate(record, txtRecord)) {
+            records |= TxtRecord;
+        }
+    }
+    if (!records) {
+        return;
+    }
+
+    for (auto i = pendingReplies.begin(); i != pendingReplies.end();) {
+        if (i->reply.address().protocol() == message.address().protocol() &&
+                (!i->reply.interfaceIndex() || !message.interfaceIndex() ||
+                 i->reply.interfaceIndex() == message.interfaceIndex())) {
+            for (int removed = i->records & records; removed; removed &= removed - 1) {
+                counters.add(RecordsSuppressed);
+            }
+            i->records &= ~records;
+        }
+        i = i->records ? i + 1 : pendingReplies.erase(i);
+    }
+    if (pendingReplies.isEmpty()) {
+        replyTimer.stop();
+    }
+}
+
 void ProviderPrivate::onMessageReceived(const Message &message)
 {
-    if (!confirmed || message.isResponse()) {
+    if (!confirmed) {
         return;
     }
+    if (message.isResponse()) {
+        if (!pendingReplies.isEmpty()) {
+            suppressReplies(message);
+        }
+        return;
+    }
+    counters.add(QueriesReceived);
 
     bool sendBrowsePtr = false;
     bool sendPtr = false;
@@ -167,23 +312,56 @@ void ProviderPrivate::onMessageReceived(const Message &message)
         sendSrv = sendTxt = true;
     }
 
-    // If any records should be sent, compose a message reply
-    if (sendBrowsePtr || sendPtr || sendSrv || sendTxt) {
-        Message reply;
-        reply.reply(message);
-        if (sendBrowsePtr) {
-            reply.addRecord(browsePtrRecord);
-        }
-        if (sendPtr) {
-            reply.addRecord(ptrRecord);
-        }
-        if (sendSrv) {
-            reply.addRecord(srvRecord);
-        }
-        if (sendTxt) {
-            reply.addRecord(txtRecord);
+    int replyRecords = (sendBrowsePtr ? BrowsePtrRecord : 0) | (sendPtr ? PtrRecord : 0) |
+        (sendSrv ? SrvRecord : 0) | (sendTxt ? TxtRecord : 0);
+    if (!replyRecords) {
+        return;
+    }
+
+    Message reply;
+    reply.reply(message);
+
+    // Unique records are sent right away, but other hosts may also hold PTR
+    // records for the same name, so multicast replies containing them are
+    // delayed by 20-120 ms (RFC 6762 section 6) giving this host the chance
+    // to see another responder's answer first; replies to the same
+    // destination are combined
+    if (!(sendBrowsePtr || sendPtr) || message.port() != MdnsPort) {
+        sendReply(reply, replyRecords);
+        return;
+    }
+    for (PendingReply &pending : pendingReplies) {
+        if (pending.reply.address() == reply.address() &&
+                pending.reply.interfaceIndex() == reply.interfaceIndex()) {
+            pending.records |= replyRecords;
+            return;
         }
-        server->sendMessage(reply);
+    }
+    pendingReplies.append({reply, replyRecords});
+    if (!replyTimer.isActive()) {
+#ifdef USE_QRANDOMGENERATOR
+        replyTimer.start(20 + QRandomGenerator::global()->bounded(101));
+#else
+        replyTimer.start(20 + qrand() % 101);
+#endif
+    }
+}
+
+void ProviderPrivate::onInterfacesChanged()
+{
+    // Announce the records on any new links right away instead of waiting
+    // for hosts there to query for them
+    if (confirmed) {
+        announce();
+    }
+}
+
+void ProviderPrivate::onReplyTimeout()
+{
+    const QList<PendingReply> pending = pendingReplies;
+    pendingReplies.clear();
+    for (const PendingReply &entry : pending) {
+        sendReply(entry.reply, entry.records);
     }
 }
 
@@ -233,3 +411,8 @@ void Provider::update(const Service &service)
         }
     }
 }
+
+Statistics Provider::statistics() const
+{
+    return d->counters.statistics();
+}
@@ -25,17 +25,23 @@
 #ifndef QMDNSENGINE_PROVIDER_P_H
 #define QMDNSENGINE_PROVIDER_P_H
 
+#include <QHash>
+#include <QList>
 #include <QObject>
 
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/preparedmessage.h>
 #include <qmdnsengine/record.h>
 #include <qmdnsengine/service.h>
 
+#include "counters_p.h"
+#include "timer_p.h"
+
 namespace QMdnsEngine
 {
 
 class AbstractServer;
 class Hostname;
-class Message;
 class Prober;
 
 class ProviderPrivate : public QObject
@@ -44,6 +50,22 @@ class ProviderPrivate : public QObject
 
 public:
 
+    struct PendingReply
+    {
+        Message reply;
+        int records;
+    };
+
+    enum Counter {
+        QueriesReceived,
+        RepliesSent,
+        RecordsSuppressed,
+        Announcements,
+        Probes,
+        Conflicts,
+        CounterCount
+    };
+
     ProviderPrivate(QObject *parent, AbstractServer *server, Hostname *hostname);
     virtual ~ProviderPrivate();
 
@@ -51,6 +73,8 @@ public:
     void confirm();
     void farewell();
     void publish();
+    void sendReply(const Message &reply, int records);
+    void suppressReplies(const Message &message);
 
     AbstractServer *server;
     Hostname *hostname;
@@ -70,10 +94,20 @@ public:
     Record srvProposed;
     Record txtProposed;
 
+    PreparedMessage announcement;
+    QHash<int, PreparedMessage> replies;
+
+    QList<PendingReply> pendingReplies;
+    Timer replyTimer;
+
+    Counters counters;
+
 private Q_SLOTS:
 
     void onMessageReceived(const Message &message);
     void onHostnameChanged(const QByteArray &hostname);
+    void onInterfacesChanged();
+    void onReplyTimeout();
 };
 
 }
@@ -22,7 +22,6 @@
  * IN THE SOFTWARE.
  */
 
-#include <QTimer>
 
 #include <qmdnsengine/abstractserver.h>
 #include <qmdnsengine/dns.h>
@@ -41,10 +40,20 @@ ResolverPrivate::ResolverPrivate(Resolver *resolver, AbstractServer *server, con
       server(server),
       name(name),
       cache(cache ? cache : new Cache(this)),
+      created(currentTime(server->clock())),
+      resolvedOnce(false),
       q(resolver)
 {
-    connect(server, &AbstractServer::messageReceived, this, &ResolverPrivate::onMessageReceived);
-    connect(&timer, &QTimer::timeout, this, &ResolverPrivate::onTimeout);
+    server->setMessageHandler(this, [this](const Message &message) {
+        onMessageReceived(message);
+    });
+    server->subscribe(this, name, A);
+    server->subscribe(this, name, AAAA);
+    if (!cache) {
+        this->cache->setClock(server->clock());
+    }
+    timer.setClock(server->clock());
+    connect(&timer, &Timer::timeout, this, &ResolverPrivate::onTimeout);
 
     // Query for new records
     query();
@@ -84,6 +93,14 @@ void ResolverPrivate::query() const
     server->sendMessageToAll(message);
 }
 
+void ResolverPrivate::recordResolved()
+{
+    if (!resolvedOnce) {
+        server->recordLatency(AbstractServer::ResolveLatency, currentTime(server->clock()) - created);
+        resolvedOnce = true;
+    }
+}
+
 void ResolverPrivate::onMessageReceived(const Message &message)
 {
     if (!message.isResponse()) {
@@ -94,6 +111,7 @@ void ResolverPrivate::onMessageReceived(const Message &message)
         if (record.name() == name && (record.type() == A || record.type() == AAAA)) {
             cache->addRecord(record);
             if (!addresses.contains(record.address())) {
+                recordResolved();
                 emit q->resolved(record.address());
                 addresses.insert(record.address());
             }
@@ -105,6 +123,7 @@ void ResolverPrivate::onTimeout()
 {
     const auto records = existing();
     for (const Record &record : records) {
+        recordResolved();
         emit q->resolved(record.address());
     }
 }
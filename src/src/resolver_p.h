@@ -28,7 +28,8 @@
 #include <QHostAddress>
 #include <QObject>
 #include <QSet>
-#include <QTimer>
+
+#include "timer_p.h"
 
 namespace QMdnsEngine
 {
@@ -49,12 +50,16 @@ public:
 
     QList<Record> existing() const;
     void query() const;
+    void recordResolved();
 
     AbstractServer *server;
     QByteArray name;
     Cache *cache;
     QSet<QHostAddress> addresses;
-    QTimer timer;
+    Timer timer;
+
+    qint64 created;
+    bool resolvedOnce;
 
 private Q_SLOTS:
 
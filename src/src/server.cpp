@@ -22,6 +22,8 @@
  * IN THE SOFTWARE.
  */
 
+#include <utility>
+
 #include <QtGlobal>
 
 #ifdef Q_OS_UNIX
@@ -30,29 +32,296 @@
 #  include <sys/socket.h>
 #endif
 
+#ifdef Q_OS_LINUX
+#  include <linux/netlink.h>
+#  include <linux/rtnetlink.h>
+#  include <netinet/in.h>
+#  include <unistd.h>
+#endif
+
 #include <QHostAddress>
 #include <QNetworkInterface>
+#include <QSocketNotifier>
+#include <QThread>
+
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 8, 0))
+#  include <QNetworkDatagram>
+#endif
 
 #include <qmdnsengine/dns.h>
 #include <qmdnsengine/mdns.h>
 #include <qmdnsengine/message.h>
+#include <qmdnsengine/preparedmessage.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
 #include <qmdnsengine/server.h>
+#include <qmdnsengine/statistics.h>
 
 #include "server_p.h"
 
 using namespace QMdnsEngine;
 
-ServerPrivate::ServerPrivate(Server *server)
+// Merged messages are kept small enough to fit in a typical Ethernet frame
+const int MaxMergedSize = 1440;
+
+// Size of the header at the start of every DNS message
+const int HeaderSize = 12;
+
+// Default time spent gathering multicast responses before sending them
+const int DefaultCoalescingInterval = 20;
+
+static bool sameQuery(const Query &query, const Query &other)
+{
+    return query.name() == other.name() &&
+        query.type() == other.type() &&
+        query.unicastResponse() == other.unicastResponse();
+}
+
+static bool hasSharedRecord(const Message &message)
+{
+    const auto records = message.records();
+    for (const Record &record : records) {
+        if (!record.flushCache()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static int querySize(const Query &query)
+{
+    // Without name compression, a query takes up at least as much space as
+    // it does in any larger message
+    Message message;
+    message.addQuery(query);
+    QByteArray packet;
+    toPacket(message, packet);
+    return packet.size() - HeaderSize;
+}
+
+static int recordSize(const Record &record)
+{
+    Message message;
+    message.addRecord(record);
+    QByteArray packet;
+    toPacket(message, packet);
+    return packet.size() - HeaderSize;
+}
+
+ServerRelay::ServerRelay(Server *server)
     : QObject(server),
       q(server)
+{
+}
+
+void ServerRelay::post(const Message &message)
+{
+    // Only wake the receiving thread if it isn't already due to run
+    messages.push(message);
+    if (posted.testAndSetOrdered(0, 1)) {
+        QMetaObject::invokeMethod(this, "onMessagesPosted", Qt::QueuedConnection);
+    }
+}
+
+void ServerRelay::onMessagesPosted()
+{
+    // Clear the flag first so that messages posted while the queue is being
+    // drained cause another wakeup
+    posted.storeRelease(0);
+    Message message;
+    while (messages.pop(message)) {
+        emit q->messageReceived(message);
+    }
+}
+
+ServerPrivate::ServerPrivate(Server *server, Server::ThreadMode mode)
+    : ServerBase(server, CounterCount, mode == Server::CurrentThread ? server : nullptr),
+      thread(nullptr),
+      relay(nullptr),
+      coalescingInterval(DefaultCoalescingInterval),
+      netlinkSocket(-1),
+      netlinkNotifier(nullptr)
+#ifdef Q_OS_LINUX
+      , rearmPort(0)
+#endif
 {
     connect(&timer, &QTimer::timeout, this, &ServerPrivate::onTimeout);
+    connect(&netlinkTimer, &QTimer::timeout, this, &ServerPrivate::onTimeout);
+    connect(&coalescingTimer, &QTimer::timeout, this, &ServerPrivate::onCoalescingTimeout);
     connect(&ipv4Socket, &QUdpSocket::readyRead, this, &ServerPrivate::onReadyRead);
     connect(&ipv6Socket, &QUdpSocket::readyRead, this, &ServerPrivate::onReadyRead);
 
     timer.setInterval(60 * 1000);
     timer.setSingleShot(true);
-    onTimeout();
+
+    // Changes tend to arrive in bursts (a link coming up is followed by its
+    // addresses), so wait for them to settle before enumerating interfaces
+    netlinkTimer.setInterval(250);
+    netlinkTimer.setSingleShot(true);
+
+    coalescingTimer.setSingleShot(true);
+
+#if (QT_VERSION < QT_VERSION_CHECK(5, 8, 0)) && !defined(Q_OS_LINUX)
+    // Without QNetworkDatagram (or batched writes on Linux), the interface
+    // of an outgoing datagram can't be chosen
+    selectsInterfaces = false;
+#endif
+
+    if (mode == Server::CurrentThread) {
+        onStarted();
+        return;
+    }
+
+    // Move this object and everything that it owns to a new thread (the
+    // members must be children to move along with it) - sockets are only
+    // bound once the thread is running; the object is destroyed on the
+    // thread when it finishes
+
+    relay = new ServerRelay(server);
+    thread = new QThread(server);
+
+    timer.setParent(this);
+    netlinkTimer.setParent(this);
+    coalescingTimer.setParent(this);
+    ipv4Socket.setParent(this);
+    ipv6Socket.setParent(this);
+    moveToThread(thread);
+
+    connect(thread, &QThread::started, this, &ServerPrivate::onStarted);
+    connect(thread, &QThread::finished, this, &QObject::deleteLater);
+    thread->start();
+}
+
+ServerPrivate::~ServerPrivate()
+{
+#ifdef Q_OS_LINUX
+    if (netlinkSocket != -1) {
+        delete netlinkNotifier;
+        ::close(netlinkSocket);
+    }
+#endif
+}
+
+void ServerPrivate::queueMessage(const Message &message, bool toAll, const QByteArray &packet)
+{
+    // Hand the message to the I/O thread, waking it only if it isn't already
+    // due to run
+    outgoing.push({message, toAll, packet, 0});
+    if (queued.testAndSetOrdered(0, 1)) {
+        QMetaObject::invokeMethod(this, "onMessagesQueued", Qt::QueuedConnection);
+    }
+}
+
+void ServerPrivate::sendMessage(const Message &message, bool toAll, const QByteArray &packet)
+{
+    if (!scheduleMessage(message, toAll, packet)) {
+        writeMessage(message, toAll, packet);
+    }
+}
+
+bool ServerPrivate::scheduleMessage(const Message &message, bool toAll, const QByteArray &packet)
+{
+    // Only responses bound for the multicast groups that contain shared
+    // records are held back - queries (including probes) and responses with
+    // only unique records must be sent without delay (RFC 6762 section 6),
+    // while those with a transaction ID (legacy unicast replies) and
+    // truncated messages must be sent exactly as they are
+
+    int interval = coalescingInterval.loadAcquire();
+    if (!interval || !message.isResponse() || message.transactionId() || message.isTruncated()) {
+        return false;
+    }
+    if (!toAll && (message.port() != MdnsPort ||
+            (message.address() != MdnsIpv4Address && message.address() != MdnsIpv6Address))) {
+        return false;
+    }
+    if (!hasSharedRecord(message)) {
+        return false;
+    }
+
+    // The size of the packet is tracked from here on so that merging does not
+    // require serializing the merged message each time
+    QByteArray scheduledPacket = packet;
+    if (scheduledPacket.isNull()) {
+        toPacket(message, scheduledPacket);
+    }
+    scheduled.append({message, toAll, scheduledPacket, scheduledPacket.size()});
+    if (!coalescingTimer.isActive()) {
+        coalescingTimer.start(interval);
+    }
+    return true;
+}
+
+bool ServerPrivate::mergeMessage(Outgoing &entry, const Message &other)
+{
+    // Add the queries and records that aren't already in the message and
+    // ensure that the result still fits in a single packet - the size of
+    // each addition is counted without name compression, so the size of the
+    // merged packet can only be overestimated
+
+    if (entry.message.isResponse() != other.isResponse() ||
+            entry.message.interfaceIndex() != other.interfaceIndex()) {
+        return false;
+    }
+
+    int size = entry.size;
+    QList<Query> newQueries;
+    QList<Record> newRecords;
+    const auto queries = entry.message.queries();
+    const auto otherQueries = other.queries();
+    for (const Query &query : otherQueries) {
+        bool found = false;
+        for (const Query &existing : queries) {
+            if (sameQuery(query, existing)) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            size += querySize(query);
+            newQueries.append(query);
+        }
+    }
+    const auto records = entry.message.records();
+    const auto otherRecords = other.records();
+    for (const Record &record : otherRecords) {
+        bool found = false;
+        for (const Record &existing : records) {
+            if (sameRecord(record, existing)) {
+                found = true;
+                break;
+            }
+        }
+        if (!found) {
+            size += recordSize(record);
+            newRecords.append(record);
+        }
+    }
+    if (size > MaxMergedSize) {
+        return false;
+    }
+
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
+    for (const Query &query : std::as_const(newQueries)) {
+#else
+    for (const Query &query : qAsConst(newQueries)) {
+#endif
+        entry.message.addQuery(query);
+    }
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
+    for (const Record &record : std::as_const(newRecords)) {
+#else
+    for (const Record &record : qAsConst(newRecords)) {
+#endif
+        entry.message.addRecord(record);
+    }
+
+    // The message is serialized once when it is written
+    if (!newQueries.isEmpty() || !newRecords.isEmpty()) {
+        entry.size = size;
+        entry.packet = QByteArray();
+    }
+    return true;
 }
 
 bool ServerPrivate::bindSocket(QUdpSocket &socket, const QHostAddress &address)
@@ -71,89 +340,411 @@ bool ServerPrivate::bindSocket(QUdpSocket &socket, const QHostAddress &address)
         int arg = 1;
         if (setsockopt(socket.socketDescriptor(), SOL_SOCKET, SO_REUSEADDR,
                 reinterpret_cast<char*>(&arg), sizeof(int))) {
-            emit q->error(strerror(errno));
+            reportError(strerror(errno));
             return false;
         }
 #endif
         if (!socket.bind(address, MdnsPort, QAbstractSocket::ReuseAddressHint)) {
-            emit q->error(socket.errorString());
+            reportError(socket.errorString());
             return false;
         }
 #ifdef Q_OS_UNIX
     }
 #endif
 
+#ifdef Q_OS_LINUX
+    // Have the kernel report which interface each datagram arrived on
+    int arg = 1;
+    if (address.protocol() == QAbstractSocket::IPv4Protocol) {
+        setsockopt(socket.socketDescriptor(), IPPROTO_IP, IP_PKTINFO, &arg, sizeof(int));
+    } else {
+        setsockopt(socket.socketDescriptor(), IPPROTO_IPV6, IPV6_RECVPKTINFO, &arg, sizeof(int));
+    }
+#endif
+
     return true;
 }
 
+void ServerPrivate::openNetlink()
+{
+#ifdef Q_OS_LINUX
+
+    // Subscribe to rtnetlink notifications for links and addresses so that
+    // changes are noticed as they happen instead of once per minute
+
+    netlinkSocket = ::socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+    if (netlinkSocket == -1) {
+        return;
+    }
+
+    sockaddr_nl address;
+    memset(&address, 0, sizeof(sockaddr_nl));
+    address.nl_family = AF_NETLINK;
+    address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+    if (::bind(netlinkSocket, reinterpret_cast<sockaddr*>(&address), sizeof(sockaddr_nl))) {
+        ::close(netlinkSocket);
+        netlinkSocket = -1;
+        return;
+    }
+
+    netlinkNotifier = new QSocketNotifier(netlinkSocket, QSocketNotifier::Read, this);
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 0, 0))
+    connect(netlinkNotifier, &QSocketNotifier::activated, this, &ServerPrivate::onNetlinkActivated);
+#else
+    // Qt 5.15 overloads activated(), which rules out a member pointer
+    connect(netlinkNotifier, SIGNAL(activated(int)), this, SLOT(onNetlinkActivated()));
+#endif
+
+#endif
+}
+
+void ServerPrivate::flush()
+{
+    onMessagesQueued();
+    onCoalescingTimeout();
+}
+
+void ServerPrivate::onStarted()
+{
+    openNetlink();
+    onTimeout();
+}
+
+void ServerPrivate::onMessagesQueued()
+{
+    // The messages are all written together once the queue is empty
+    queued.storeRelease(0);
+    deferWrites = true;
+    Outgoing entry;
+    while (outgoing.pop(entry)) {
+        sendMessage(entry.message, entry.toAll, entry.packet);
+    }
+    deferWrites = false;
+    flushDatagrams();
+}
+
+void ServerPrivate::onCoalescingTimeout()
+{
+    // Merge each message into the last one with the same destination, then
+    // write them all together
+
+    coalescingTimer.stop();
+
+    QList<Outgoing> merged;
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
+    for (const Outgoing &entry : std::as_const(scheduled)) {
+#else
+    for (const Outgoing &entry : qAsConst(scheduled)) {
+#endif
+        int index = merged.count() - 1;
+        for (; index >= 0; --index) {
+            const Outgoing &candidate = merged.at(index);
+            if (candidate.toAll == entry.toAll && (entry.toAll ||
+                    (candidate.message.address() == entry.message.address() &&
+                     candidate.message.port() == entry.message.port()))) {
+                break;
+            }
+        }
+        if (index >= 0 && mergeMessage(merged[index], entry.message)) {
+            counters.add(MessagesCoalesced);
+        } else {
+            merged.append(entry);
+        }
+    }
+    scheduled.clear();
+
+    deferWrites = true;
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
+    for (const Outgoing &entry : std::as_const(merged)) {
+#else
+    for (const Outgoing &entry : qAsConst(merged)) {
+#endif
+        writeMessage(entry.message, entry.toAll, entry.packet);
+    }
+    deferWrites = false;
+    flushDatagrams();
+}
+
 void ServerPrivate::onTimeout()
 {
-    // A timer is used to run a set of operations once per minute; first, the
-    // two sockets are bound - if this fails, another attempt is made once per
-    // timeout; secondly, all network interfaces are enumerated; if the
-    // interface supports multicast, the socket will join the mDNS multicast
-    // groups
+    // The sockets are bound - if this fails, another attempt is made on the
+    // next timeout - and the interfaces are updated; when rtnetlink is not
+    // available, the interfaces are polled once per minute instead
 
     bool ipv4Bound = bindSocket(ipv4Socket, QHostAddress::AnyIPv4);
     bool ipv6Bound = bindSocket(ipv6Socket, QHostAddress::AnyIPv6);
 
     if (ipv4Bound || ipv6Bound) {
-        const auto interfaces = QNetworkInterface::allInterfaces();
-        for (const QNetworkInterface &networkInterface : interfaces) {
-            if (networkInterface.flags() & QNetworkInterface::CanMulticast) {
-                if (ipv4Bound) {
-                    ipv4Socket.joinMulticastGroup(MdnsIpv4Address, networkInterface);
-                }
-                if (ipv6Bound) {
-                    ipv6Socket.joinMulticastGroup(MdnsIpv6Address, networkInterface);
-                }
-            }
+        updateInterfaces(ipv4Bound, ipv6Bound);
+    }
+
+    if (!netlinkNotifier || !ipv4Bound || !ipv6Bound) {
+        timer.start();
+    }
+}
+
+void ServerPrivate::onNetlinkActivated()
+{
+#ifdef Q_OS_LINUX
+    // The contents of the notifications are not needed since the interfaces
+    // are enumerated again, so simply drain the socket
+    char buffer[4096];
+    while (::recv(netlinkSocket, buffer, sizeof(buffer), 0) > 0) {}
+#endif
+    netlinkTimer.start();
+}
+
+void ServerPrivate::readDatagrams(QUdpSocket &socket)
+{
+    // Any replies sent while the datagrams are being processed are held
+    // until all of them have been read so that they can be sent together
+    deferWrites = true;
+
+#ifdef Q_OS_LINUX
+
+    // Drain the socket with recvmmsg(), receiving up to BatchSize datagrams
+    // per call
+    forever {
+        if (receiveDatagrams(socket.socketDescriptor()) == BatchSize) {
+            continue;
+        }
+
+        // QUdpSocket stops watching the socket until a datagram is read
+        // through it; pick up any datagram that arrived after recvmmsg()
+        // returned or else re-arm it without allocating anything
+        if (!socket.hasPendingDatagrams()) {
+            rearmSocket(socket);
+            break;
+        }
+        if (!readPendingDatagram(socket)) {
+            break;
         }
     }
 
-    timer.start();
+#else
+
+    // Read every pending datagram instead of waiting for the next readyRead()
+    while (socket.hasPendingDatagrams()) {
+        if (!readPendingDatagram(socket)) {
+            break;
+        }
+    }
+
+#endif
+
+    deferWrites = false;
+    flushDatagrams();
 }
 
-void ServerPrivate::onReadyRead()
+bool ServerPrivate::readPendingDatagram(QUdpSocket &socket)
 {
-    // Read the packet from the socket
-    QUdpSocket *socket = qobject_cast<QUdpSocket*>(sender());
-    QByteArray packet;
-    packet.resize(socket->pendingDatagramSize());
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 8, 0))
+    QNetworkDatagram datagram = socket.receiveDatagram(MaxDatagramSize);
+    if (!datagram.isValid()) {
+        return false;
+    }
+    processDatagram(
+        datagram.data(),
+        datagram.senderAddress(),
+        datagram.senderPort(),
+        datagram.interfaceIndex()
+    );
+#else
     QHostAddress address;
     quint16 port;
-    socket->readDatagram(packet.data(), packet.size(), &address, &port);
+    BufferPool::Buffer buffer = bufferPool.acquire();
+    qint64 size = socket.readDatagram(buffer.data(), MaxDatagramSize, &address, &port);
+    if (size < 0) {
+        return false;
+    }
+    buffer.setSize(size);
+    processDatagram(buffer.toByteArray(), address, port, 0);
+#endif
+    return true;
+}
 
-    // Attempt to decode the packet
-    Message message;
-    if (fromPacket(packet, message)) {
-        message.setAddress(address);
-        message.setPort(port);
-        emit q->messageReceived(message);
+#ifdef Q_OS_LINUX
+
+void ServerPrivate::rearmSocket(QUdpSocket &socket)
+{
+    // The read normally finds nothing; one that races with a new datagram
+    // still gets its contents, though not the interface it arrived on
+    BufferPool::Buffer buffer = bufferPool.acquire();
+    qint64 size = socket.readDatagram(buffer.data(), MaxDatagramSize, &rearmAddress, &rearmPort);
+    if (size >= 0) {
+        buffer.setSize(size);
+        processDatagram(buffer.toByteArray(), rearmAddress, rearmPort, 0);
+    }
+}
+
+#endif
+
+bool ServerPrivate::setMembership(Family family, const QNetworkInterface &networkInterface, bool join)
+{
+    QUdpSocket &socket = family == Ipv4Family ? ipv4Socket : ipv6Socket;
+    const QHostAddress &address = family == Ipv4Family ? MdnsIpv4Address : MdnsIpv6Address;
+    return join ? socket.joinMulticastGroup(address, networkInterface) :
+        socket.leaveMulticastGroup(address, networkInterface);
+}
+
+void ServerPrivate::writeDatagrams(Family family, QList<Datagram> &datagrams)
+{
+    QUdpSocket &socket = family == Ipv4Family ? ipv4Socket : ipv6Socket;
+
+#ifdef Q_OS_LINUX
+    // If the socket is bound, send the datagrams in batches
+    if (socket.state() == QAbstractSocket::BoundState) {
+        sendDatagrams(socket.socketDescriptor(), datagrams);
+        return;
+    }
+#endif
+
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
+    for (const Datagram &datagram : std::as_const(datagrams)) {
+#else
+    for (const Datagram &datagram : qAsConst(datagrams)) {
+#endif
+#if (QT_VERSION >= QT_VERSION_CHECK(5, 8, 0))
+        QNetworkDatagram networkDatagram(datagram.packet, datagram.address, datagram.port);
+        networkDatagram.setInterfaceIndex(datagram.interfaceIndex);
+        qint64 written = socket.writeDatagram(networkDatagram);
+#else
+        qint64 written = socket.writeDatagram(datagram.packet, datagram.address, datagram.port);
+#endif
+        if (written < 0) {
+            counters.add(SendErrors);
+        } else {
+            counters.add(PacketsSent);
+            counters.add(BytesSent, written);
+        }
+    }
+    datagrams.clear();
+}
+
+void ServerPrivate::deliverMessage(const Message &message)
+{
+    // With a thread of its own, the message is handed to the owner's thread
+    if (relay) {
+        relay->post(message);
+    } else {
+        ServerBase::deliverMessage(message);
+    }
+}
+
+void ServerPrivate::reportError(const QString &message)
+{
+    // Errors are rare enough that queueing the signal itself will do
+    if (relay) {
+        QMetaObject::invokeMethod(q, "error", Qt::QueuedConnection, Q_ARG(QString, message));
+    } else {
+        ServerBase::reportError(message);
+    }
+}
+
+void ServerPrivate::reportInterfacesChanged()
+{
+    if (relay) {
+        QMetaObject::invokeMethod(q, "interfacesChanged", Qt::QueuedConnection);
+    } else {
+        ServerBase::reportInterfacesChanged();
     }
 }
 
+void ServerPrivate::onReadyRead()
+{
+    readDatagrams(*qobject_cast<QUdpSocket*>(sender()));
+}
+
 Server::Server(QObject *parent)
     : AbstractServer(parent),
-      d(new ServerPrivate(this))
+      d(new ServerPrivate(this, CurrentThread))
+{
+}
+
+Server::Server(ThreadMode mode, QObject *parent)
+    : AbstractServer(parent),
+      d(new ServerPrivate(this, mode))
 {
 }
 
+Server::~Server()
+{
+    // Send anything that is still waiting, such as goodbye messages from
+    // providers destroyed just before the server, while the server is intact
+    // enough to report errors; the private object deletes itself when its
+    // thread finishes, so the thread pointer must be kept aside
+    QThread *thread = d->thread;
+    if (thread) {
+        QMetaObject::invokeMethod(d, "flush", Qt::BlockingQueuedConnection);
+        thread->quit();
+        thread->wait();
+    } else {
+        d->flush();
+    }
+}
+
 void Server::sendMessage(const Message &message)
 {
-    QByteArray packet;
-    toPacket(message, packet);
-    if (message.address().protocol() == QAbstractSocket::IPv4Protocol) {
-        d->ipv4Socket.writeDatagram(packet, message.address(), message.port());
+    if (d->thread) {
+        d->queueMessage(message, false, QByteArray());
     } else {
-        d->ipv6Socket.writeDatagram(packet, message.address(), message.port());
+        d->sendMessage(message, false, QByteArray());
     }
 }
 
 void Server::sendMessageToAll(const Message &message)
 {
-    QByteArray packet;
-    toPacket(message, packet);
-    d->ipv4Socket.writeDatagram(packet, MdnsIpv4Address, MdnsPort);
-    d->ipv6Socket.writeDatagram(packet, MdnsIpv6Address, MdnsPort);
+    if (d->thread) {
+        d->queueMessage(message, true, QByteArray());
+    } else {
+        d->sendMessage(message, true, QByteArray());
+    }
+}
+
+void Server::sendPreparedMessage(const PreparedMessage &message)
+{
+    if (d->thread) {
+        d->queueMessage(message.message(), false, message.packet());
+    } else {
+        d->sendMessage(message.message(), false, message.packet());
+    }
+}
+
+void Server::sendPreparedMessageToAll(const PreparedMessage &message)
+{
+    if (d->thread) {
+        d->queueMessage(message.message(), true, message.packet());
+    } else {
+        d->sendMessage(message.message(), true, message.packet());
+    }
+}
+
+QList<QNetworkAddressEntry> Server::addressEntries(int interfaceIndex) const
+{
+    return d->addressEntries(interfaceIndex);
+}
+
+QList<int> Server::interfaceIndices() const
+{
+    return d->interfaceIndices();
+}
+
+void Server::setCoalescingInterval(int msec)
+{
+    d->coalescingInterval.storeRelease(qBound(0, msec, 120));
+}
+
+quint64 Server::suppressedRecords() const
+{
+    return d->counters.value(ServerPrivate::RecordsSuppressed);
+}
+
+quint64 Server::suppressedMessages() const
+{
+    return d->counters.value(ServerPrivate::MessagesSuppressed);
+}
+
+Statistics Server::statistics() const
+{
+    return d->counters.statistics();
 }
@@ -25,39 +25,119 @@
 #ifndef QMDNSENGINE_SERVER_P_H
 #define QMDNSENGINE_SERVER_P_H
 
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QHostAddress>
+#include <QList>
+#include <QNetworkInterface>
 #include <QObject>
 #include <QTimer>
 #include <QUdpSocket>
 
-class QHostAddress;
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/server.h>
+
+#include "serverbase_p.h"
+#include "spscqueue_p.h"
+
+class QSocketNotifier;
+class QThread;
 
 namespace QMdnsEngine
 {
 
-class Server;
+class ServerRelay : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    explicit ServerRelay(Server *server);
+
+    void post(const Message &message);
 
-class ServerPrivate : public QObject
+private Q_SLOTS:
+
+    void onMessagesPosted();
+
+private:
+
+    SpscQueue<Message> messages;
+    QAtomicInt posted;
+
+    Server *const q;
+};
+
+class ServerPrivate : public ServerBase
 {
     Q_OBJECT
 
 public:
 
-    explicit ServerPrivate(Server *server);
+    struct Outgoing
+    {
+        Message message;
+        bool toAll;
+        QByteArray packet;
+        int size;
+    };
+
+    ServerPrivate(Server *server, Server::ThreadMode mode);
+    virtual ~ServerPrivate();
+
+    void queueMessage(const Message &message, bool toAll, const QByteArray &packet);
+    void sendMessage(const Message &message, bool toAll, const QByteArray &packet);
+    bool scheduleMessage(const Message &message, bool toAll, const QByteArray &packet);
+    bool mergeMessage(Outgoing &entry, const Message &other);
+    Q_INVOKABLE void flush();
 
     bool bindSocket(QUdpSocket &socket, const QHostAddress &address);
+    void openNetlink();
+
+    void readDatagrams(QUdpSocket &socket);
+    bool readPendingDatagram(QUdpSocket &socket);
+#ifdef Q_OS_LINUX
+    void rearmSocket(QUdpSocket &socket);
+#endif
+
+    virtual bool setMembership(Family family, const QNetworkInterface &networkInterface, bool join);
+    virtual void writeDatagrams(Family family, QList<Datagram> &datagrams);
+    virtual void deliverMessage(const Message &message);
+    virtual void reportError(const QString &message);
+    virtual void reportInterfacesChanged();
+
+    QThread *thread;
+    ServerRelay *relay;
+    SpscQueue<Outgoing> outgoing;
+    QAtomicInt queued;
+
+    QAtomicInt coalescingInterval;
+    QTimer coalescingTimer;
+    QList<Outgoing> scheduled;
 
     QTimer timer;
     QUdpSocket ipv4Socket;
     QUdpSocket ipv6Socket;
 
+    int netlinkSocket;
+    QSocketNotifier *netlinkNotifier;
+    QTimer netlinkTimer;
+
+#ifdef Q_OS_LINUX
+    // Sender of a datagram read while re-arming a socket, kept to avoid an
+    // allocation on every read
+    QHostAddress rearmAddress;
+    quint16 rearmPort;
+#endif
+
 private Q_SLOTS:
 
+    void onStarted();
+    void onMessagesQueued();
+    void onCoalescingTimeout();
     void onTimeout();
+    void onNetlinkActivated();
     void onReadyRead();
-
-private:
-
-    Server *const q;
 };
 
 }
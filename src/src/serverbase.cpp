@@ -0,0 +1,518 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <utility>
+
+#include <QtGlobal>
+
+#ifdef Q_OS_LINUX
+#  include <cerrno>
+#  include <cstring>
+#  include <sys/socket.h>
+#endif
+
+#include <QNetworkAddressEntry>
+
+#include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/mdns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/query.h>
+
+#include "serverbase_p.h"
+#include "socketutil_p.h"
+
+using namespace QMdnsEngine;
+
+// RFC 6762 section 6 limits each record to one multicast per second
+const qint64 MulticastInterval = 1000;
+
+// Names of the counters in ServerBase::Counter
+static const char *const CounterNames[] = {
+    "packets_received",
+    "bytes_received",
+    "parse_failures",
+    "packets_sent",
+    "bytes_sent",
+    "send_errors",
+    "records_suppressed",
+    "messages_suppressed",
+    "messages_coalesced"
+};
+
+static void addTargets(QList<QPair<int, int>> &targets, int family, const QList<int> &indices, int interfaceIndex)
+{
+    // Mirror writeMulticast(), which uses the system's choice of interface
+    // (index 0) if there are none to send a copy out of
+    if (interfaceIndex || indices.isEmpty()) {
+        targets.append(qMakePair(interfaceIndex, family));
+    } else {
+        for (int index : indices) {
+            targets.append(qMakePair(index, family));
+        }
+    }
+}
+
+static ServerBase::Multicast *findMulticast(QList<ServerBase::Multicast> &sent, const Record &record,
+                                            const QPair<int, int> &target)
+{
+    for (ServerBase::Multicast &multicast : sent) {
+        if (multicast.interfaceIndex == target.first && multicast.family == target.second &&
+                ServerBase::sameRecord(multicast.record, record)) {
+            return &multicast;
+        }
+    }
+    return nullptr;
+}
+
+ServerBase::ServerBase(AbstractServer *server, int counterCount, QObject *parent)
+    : QObject(parent),
+      lastPurge(0),
+      bufferPool(MaxDatagramSize, 2 * BatchSize),
+      counters(CounterNames, counterCount),
+      selectsInterfaces(true),
+      deferWrites(false),
+      q(server)
+{
+    clock.start();
+}
+
+ServerBase::~ServerBase()
+{
+}
+
+bool ServerBase::sameRecord(const Record &record, const Record &other)
+{
+    return record == other &&
+        record.ttl() == other.ttl() &&
+        record.flushCache() == other.flushCache();
+}
+
+void ServerBase::writeMessage(const Message &original, bool toAll, const QByteArray &preparedPacket)
+{
+    // Messages that were prepared in advance are not serialized again unless
+    // records had to be removed from them
+
+    const Message *message = &original;
+    QByteArray packet = preparedPacket;
+
+    Message limited;
+    if (limitRecords(original, toAll, limited)) {
+        if (limited.queries().isEmpty() && limited.records().isEmpty()) {
+            counters.add(MessagesSuppressed);
+            return;
+        }
+        message = &limited;
+        packet = QByteArray();
+    }
+
+    if (packet.isNull()) {
+        toPacket(*message, packet);
+    }
+    if (toAll) {
+        writeMulticast(Ipv4Family, packet, message->interfaceIndex());
+        writeMulticast(Ipv6Family, packet, message->interfaceIndex());
+    } else {
+        writeDatagram(message->address().protocol() == QAbstractSocket::IPv4Protocol ? Ipv4Family : Ipv6Family,
+                      packet, message->address(), message->port(), message->interfaceIndex());
+    }
+    flushDatagrams();
+}
+
+int ServerBase::limitRecords(const Message &message, bool toAll, Message &limited)
+{
+    // Remove records from multicast responses if an identical record was
+    // multicast within the last second on every interface and address family
+    // that the response is sent to, unless a probe for the name was received
+    // in that time - the number of records removed is returned
+
+    if (!message.isResponse() || (!toAll && message.port() != MdnsPort)) {
+        return 0;
+    }
+
+    // Determine where the response actually goes, so that a record sent to a
+    // link that has just come up is not suppressed because of a copy sent
+    // out of the other interfaces
+    QList<QPair<int, int>> targets;
+    const int interfaceIndex = selectsInterfaces ? message.interfaceIndex() : 0;
+    if (toAll && selectsInterfaces) {
+        addTargets(targets, Ipv4Family, ipv4Interfaces, interfaceIndex);
+        addTargets(targets, Ipv6Family, ipv6Interfaces, interfaceIndex);
+    } else if (toAll) {
+        addTargets(targets, Ipv4Family, QList<int>(), interfaceIndex);
+        addTargets(targets, Ipv6Family, QList<int>(), interfaceIndex);
+    } else if (message.address() == MdnsIpv4Address) {
+        addTargets(targets, Ipv4Family, QList<int>(), interfaceIndex);
+    } else if (message.address() == MdnsIpv6Address) {
+        addTargets(targets, Ipv6Family, QList<int>(), interfaceIndex);
+    } else {
+        return 0;
+    }
+
+    qint64 now = clock.elapsed();
+    if (now - lastPurge >= MulticastInterval) {
+        purgeMulticasts(now);
+    }
+
+    int removed = 0;
+    QList<Record> records;
+    const auto messageRecords = message.records();
+    for (const Record &record : messageRecords) {
+        QList<Multicast> &sent = multicasts[qMakePair(record.name(), record.type())];
+        auto probe = probes.constFind(record.name());
+        bool suppress = probe == probes.constEnd() || now - probe.value() >= MulticastInterval;
+        for (int i = 0; suppress && i < targets.count(); ++i) {
+            const Multicast *multicast = findMulticast(sent, record, targets.at(i));
+            suppress = multicast && now - multicast->time < MulticastInterval;
+        }
+        if (suppress) {
+            ++removed;
+            continue;
+        }
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
+        for (const auto &target : std::as_const(targets)) {
+#else
+        for (const auto &target : qAsConst(targets)) {
+#endif
+            Multicast *multicast = findMulticast(sent, record, target);
+            if (multicast) {
+                multicast->time = now;
+            } else {
+                sent.append({record, target.first, target.second, now});
+            }
+        }
+        records.append(record);
+    }
+
+    if (removed) {
+        counters.add(RecordsSuppressed, removed);
+        limited.setAddress(message.address());
+        limited.setPort(message.port());
+        limited.setInterfaceIndex(message.interfaceIndex());
+        limited.setTransactionId(message.transactionId());
+        limited.setResponse(true);
+        limited.setTruncated(message.isTruncated());
+        const auto queries = message.queries();
+        for (const Query &query : queries) {
+            limited.addQuery(query);
+        }
+#if (QT_VERSION >= QT_VERSION_CHECK(6, 6, 0))
+        for (const Record &record : std::as_const(records)) {
+#else
+        for (const Record &record : qAsConst(records)) {
+#endif
+            limited.addRecord(record);
+        }
+    }
+    return removed;
+}
+
+void ServerBase::purgeMulticasts(qint64 now)
+{
+    lastPurge = now;
+    for (auto i = multicasts.begin(); i != multicasts.end();) {
+        QList<Multicast> &sent = i.value();
+        for (auto j = sent.begin(); j != sent.end();) {
+            j = now - j->time >= MulticastInterval ? sent.erase(j) : j + 1;
+        }
+        if (sent.isEmpty()) {
+            i = multicasts.erase(i);
+        } else {
+            ++i;
+        }
+    }
+    for (auto i = probes.begin(); i != probes.end();) {
+        if (now - i.value() >= MulticastInterval) {
+            i = probes.erase(i);
+        } else {
+            ++i;
+        }
+    }
+}
+
+void ServerBase::updateInterfaces(bool ipv4Bound, bool ipv6Bound)
+{
+    // Enumerate all network interfaces and keep their addresses for replies;
+    // if the interface supports multicast, the sockets join the mDNS
+    // multicast groups on it and, if it is running, it is used for sending
+    // multicast messages
+
+    QMap<int, QNetworkInterface> interfaces;
+    QList<int> newIpv4Interfaces;
+    QList<int> newIpv6Interfaces;
+    QHash<int, QList<QNetworkAddressEntry>> newAddresses;
+
+    const auto networkInterfaces = QNetworkInterface::allInterfaces();
+    for (const QNetworkInterface &networkInterface : networkInterfaces) {
+        newAddresses.insert(networkInterface.index(), networkInterface.addressEntries());
+        if (networkInterface.flags() & QNetworkInterface::CanMulticast) {
+            interfaces.insert(networkInterface.index(), networkInterface);
+            if (networkInterface.flags() & QNetworkInterface::IsRunning) {
+                const auto entries = networkInterface.addressEntries();
+                for (const QNetworkAddressEntry &entry : entries) {
+                    QList<int> &indices = entry.ip().protocol() == QAbstractSocket::IPv4Protocol ?
+                        newIpv4Interfaces : newIpv6Interfaces;
+                    if (!indices.contains(networkInterface.index())) {
+                        indices.append(networkInterface.index());
+                    }
+                }
+            }
+        }
+    }
+
+    bool changed = false;
+    if (ipv4Bound) {
+        changed |= updateMemberships(Ipv4Family, interfaces, ipv4Memberships);
+    }
+    if (ipv6Bound) {
+        changed |= updateMemberships(Ipv6Family, interfaces, ipv6Memberships);
+    }
+    if (newIpv4Interfaces != ipv4Interfaces || newIpv6Interfaces != ipv6Interfaces) {
+        ipv4Interfaces = newIpv4Interfaces;
+        ipv6Interfaces = newIpv6Interfaces;
+        changed = true;
+    }
+    QMutexLocker locker(&addressMutex);
+    if (newAddresses != addresses) {
+        addresses = newAddresses;
+        changed = true;
+    }
+    multicastIndices = ipv4Interfaces;
+    for (int index : ipv6Interfaces) {
+        if (!multicastIndices.contains(index)) {
+            multicastIndices.append(index);
+        }
+    }
+    locker.unlock();
+
+    if (changed) {
+        reportInterfacesChanged();
+    }
+}
+
+QList<QNetworkAddressEntry> ServerBase::addressEntries(int interfaceIndex) const
+{
+    // An interface that appeared since the last update is looked up directly
+    QMutexLocker locker(&addressMutex);
+    auto i = addresses.constFind(interfaceIndex);
+    if (i != addresses.constEnd()) {
+        return i.value();
+    }
+    locker.unlock();
+    return QNetworkInterface::interfaceFromIndex(interfaceIndex).addressEntries();
+}
+
+QList<int> ServerBase::interfaceIndices() const
+{
+    // Messages can't be directed to an interface that can't be selected
+    if (!selectsInterfaces) {
+        return QList<int>();
+    }
+    QMutexLocker locker(&addressMutex);
+    return multicastIndices;
+}
+
+bool ServerBase::updateMemberships(Family family, const QMap<int, QNetworkInterface> &interfaces,
+                                   QMap<int, QNetworkInterface> &memberships)
+{
+    // Only join or leave the group on interfaces that were added or removed;
+    // a failed join (an interface without an address, for example) is not
+    // recorded, so it is attempted again on the next update
+
+    bool changed = false;
+    for (auto i = memberships.begin(); i != memberships.end();) {
+        if (interfaces.contains(i.key())) {
+            ++i;
+        } else {
+            setMembership(family, i.value(), false);
+            i = memberships.erase(i);
+            changed = true;
+        }
+    }
+    for (auto i = interfaces.constBegin(); i != interfaces.constEnd(); ++i) {
+        if (!memberships.contains(i.key()) && setMembership(family, i.value(), true)) {
+            memberships.insert(i.key(), i.value());
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+void ServerBase::processDatagram(const QByteArray &packet, const QHostAddress &address, quint16 port, int interfaceIndex)
+{
+    counters.add(PacketsReceived);
+    counters.add(BytesReceived, packet.size());
+
+    // Attempt to decode the packet
+    Message message;
+    if (fromPacket(packet, message)) {
+        message.setAddress(address);
+        message.setPort(port);
+        message.setInterfaceIndex(interfaceIndex);
+
+        // Responses to a probe are exempt from the limit on multicasting a
+        // record more than once per second; probes are queries that carry
+        // the proposed records in the authority section (known answers are
+        // in the answer section)
+        if (!message.isResponse() && message.authorityCount()) {
+            const auto queries = message.queries();
+            for (const Query &query : queries) {
+                probes.insert(query.name(), clock.elapsed());
+            }
+        }
+
+        deliverMessage(message);
+    } else {
+        counters.add(ParseFailures);
+    }
+}
+
+#ifdef Q_OS_LINUX
+
+int ServerBase::receiveDatagrams(int fd)
+{
+    // Receive up to BatchSize datagrams with a single call to recvmmsg() into
+    // buffers from the pool; the packets are parsed in place
+
+    BufferPool::Buffer buffers[BatchSize];
+    mmsghdr headers[BatchSize];
+    iovec vectors[BatchSize];
+    sockaddr_storage addresses[BatchSize];
+    ControlBuffer controls[BatchSize];
+
+    memset(headers, 0, sizeof(headers));
+    for (int i = 0; i < BatchSize; ++i) {
+        buffers[i] = bufferPool.acquire();
+        vectors[i].iov_base = buffers[i].data();
+        vectors[i].iov_len = MaxDatagramSize;
+        headers[i].msg_hdr.msg_name = &addresses[i];
+        headers[i].msg_hdr.msg_namelen = sizeof(sockaddr_storage);
+        headers[i].msg_hdr.msg_iov = &vectors[i];
+        headers[i].msg_hdr.msg_iovlen = 1;
+        headers[i].msg_hdr.msg_control = &controls[i];
+        headers[i].msg_hdr.msg_controllen = sizeof(ControlBuffer);
+    }
+
+    int count = recvmmsg(fd, headers, BatchSize, MSG_DONTWAIT, nullptr);
+    for (int i = 0; i < count; ++i) {
+        buffers[i].setSize(headers[i].msg_len);
+        processDatagram(
+            buffers[i].toByteArray(),
+            QHostAddress(reinterpret_cast<const sockaddr*>(&addresses[i])),
+            sockaddrPort(addresses[i]),
+            pktinfoIndex(headers[i].msg_hdr)
+        );
+    }
+    return count;
+}
+
+void ServerBase::sendDatagrams(int fd, QList<Datagram> &datagrams)
+{
+    // Send the queued datagrams with sendmmsg(), up to BatchSize at a time
+
+    mmsghdr headers[BatchSize];
+    iovec vectors[BatchSize];
+    sockaddr_storage addresses[BatchSize];
+    ControlBuffer controls[BatchSize];
+
+    int offset = 0;
+    while (offset < datagrams.count()) {
+        int count = qMin(BatchSize, datagrams.count() - offset);
+        memset(headers, 0, sizeof(headers));
+        for (int i = 0; i < count; ++i) {
+            const Datagram &datagram = datagrams.at(offset + i);
+            vectors[i].iov_base = const_cast<char*>(datagram.packet.constData());
+            vectors[i].iov_len = datagram.packet.size();
+            headers[i].msg_hdr.msg_name = &addresses[i];
+            headers[i].msg_hdr.msg_namelen = toSockaddr(datagram.address, datagram.port, addresses[i]);
+            headers[i].msg_hdr.msg_iov = &vectors[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+            if (datagram.interfaceIndex) {
+                headers[i].msg_hdr.msg_control = &controls[i];
+                headers[i].msg_hdr.msg_controllen = toPktinfo(
+                    datagram.address.protocol(), datagram.interfaceIndex, controls[i]);
+            }
+        }
+        int sent = sendmmsg(fd, headers, count, 0);
+        if (sent <= 0) {
+            counters.add(SendErrors);
+            reportError(strerror(errno));
+            break;
+        }
+        counters.add(PacketsSent, sent);
+        for (int i = 0; i < sent; ++i) {
+            counters.add(BytesSent, vectors[i].iov_len);
+        }
+        offset += sent;
+    }
+    datagrams.clear();
+}
+
+#endif
+
+void ServerBase::writeDatagram(Family family, const QByteArray &packet, const QHostAddress &address, quint16 port, int interfaceIndex)
+{
+    (family == Ipv4Family ? ipv4Datagrams : ipv6Datagrams).append({packet, address, port, interfaceIndex});
+}
+
+void ServerBase::writeMulticast(Family family, const QByteArray &packet, int interfaceIndex)
+{
+    // Unless the packet is restricted to a single interface, send a copy out
+    // of each interface with an address for the protocol - if there are none,
+    // or an interface can't be selected, leave it to the system to choose one
+
+    const QHostAddress &address = family == Ipv4Family ? MdnsIpv4Address : MdnsIpv6Address;
+    const QList<int> &indices = family == Ipv4Family ? ipv4Interfaces : ipv6Interfaces;
+    if (interfaceIndex || indices.isEmpty() || !selectsInterfaces) {
+        writeDatagram(family, packet, address, MdnsPort, interfaceIndex);
+    } else {
+        for (int index : indices) {
+            writeDatagram(family, packet, address, MdnsPort, index);
+        }
+    }
+}
+
+void ServerBase::flushDatagrams()
+{
+    // Datagrams are held while incoming datagrams are being processed
+    if (!deferWrites) {
+        writeDatagrams(Ipv4Family, ipv4Datagrams);
+        writeDatagrams(Ipv6Family, ipv6Datagrams);
+    }
+}
+
+void ServerBase::deliverMessage(const Message &message)
+{
+    emit q->messageReceived(message);
+}
+
+void ServerBase::reportError(const QString &message)
+{
+    emit q->error(message);
+}
+
+void ServerBase::reportInterfacesChanged()
+{
+    emit q->interfacesChanged();
+}
@@ -0,0 +1,178 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_SERVERBASE_P_H
+#define QMDNSENGINE_SERVERBASE_P_H
+
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QList>
+#include <QMap>
+#include <QMutex>
+#include <QNetworkAddressEntry>
+#include <QNetworkInterface>
+#include <QObject>
+#include <QPair>
+#include <QString>
+
+#include <qmdnsengine/record.h>
+
+#include "bufferpool_p.h"
+#include "counters_p.h"
+
+namespace QMdnsEngine
+{
+
+class AbstractServer;
+class Message;
+
+// RFC 6762 section 17 limits mDNS messages to 9000 bytes
+const int MaxDatagramSize = 9000;
+
+// Number of datagrams read or written with a single system call
+const int BatchSize = 16;
+
+// Work shared by the servers that talk to the network: tracking interfaces
+// and multicast group memberships, limiting multicast records, parsing
+// received datagrams, and queueing and batching outgoing datagrams; derived
+// classes own the sockets
+
+class ServerBase : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    enum Family {
+        Ipv4Family = 1,
+        Ipv6Family = 2
+    };
+
+    struct Datagram
+    {
+        QByteArray packet;
+        QHostAddress address;
+        quint16 port;
+        int interfaceIndex;
+    };
+
+    struct Multicast
+    {
+        Record record;
+        int interfaceIndex;
+        int family;
+        qint64 time;
+    };
+
+    // MessagesCoalesced comes last since it is only maintained by servers
+    // that coalesce outgoing messages
+    enum Counter {
+        PacketsReceived,
+        BytesReceived,
+        ParseFailures,
+        PacketsSent,
+        BytesSent,
+        SendErrors,
+        RecordsSuppressed,
+        MessagesSuppressed,
+        MessagesCoalesced,
+        CounterCount
+    };
+
+    ServerBase(AbstractServer *server, int counterCount, QObject *parent);
+    virtual ~ServerBase();
+
+    static bool sameRecord(const Record &record, const Record &other);
+
+    void writeMessage(const Message &message, bool toAll, const QByteArray &packet);
+    int limitRecords(const Message &message, bool toAll, Message &limited);
+    void purgeMulticasts(qint64 now);
+
+    void updateInterfaces(bool ipv4Bound, bool ipv6Bound);
+    QList<QNetworkAddressEntry> addressEntries(int interfaceIndex) const;
+    QList<int> interfaceIndices() const;
+    bool updateMemberships(Family family, const QMap<int, QNetworkInterface> &interfaces,
+                           QMap<int, QNetworkInterface> &memberships);
+
+    void processDatagram(const QByteArray &packet, const QHostAddress &address, quint16 port, int interfaceIndex);
+#ifdef Q_OS_LINUX
+    int receiveDatagrams(int fd);
+    void sendDatagrams(int fd, QList<Datagram> &datagrams);
+#endif
+
+    void writeDatagram(Family family, const QByteArray &packet, const QHostAddress &address, quint16 port, int interfaceIndex);
+    void writeMulticast(Family family, const QByteArray &packet, int interfaceIndex);
+    void flushDatagrams();
+
+    // Join or leave the multicast group for the family on an interface
+    virtual bool setMembership(Family family, const QNetworkInterface &networkInterface, bool join) = 0;
+
+    // Write and clear the datagrams queued for the family
+    virtual void writeDatagrams(Family family, QList<Datagram> &datagrams) = 0;
+
+    // Pass a parsed message, an error, or a change to the interfaces on to
+    // the server
+    virtual void deliverMessage(const Message &message);
+    virtual void reportError(const QString &message);
+    virtual void reportInterfacesChanged();
+
+    QElapsedTimer clock;
+    QHash<QPair<QByteArray, quint16>, QList<Multicast>> multicasts;
+    QHash<QByteArray, qint64> probes;
+    qint64 lastPurge;
+
+    QMap<int, QNetworkInterface> ipv4Memberships;
+    QMap<int, QNetworkInterface> ipv6Memberships;
+
+    QList<int> ipv4Interfaces;
+    QList<int> ipv6Interfaces;
+
+    // Addresses of each interface and the interfaces used for multicast,
+    // read from the thread that owns the server
+    mutable QMutex addressMutex;
+    QHash<int, QList<QNetworkAddressEntry>> addresses;
+    QList<int> multicastIndices;
+
+    BufferPool bufferPool;
+    Counters counters;
+
+    // Whether writeDatagrams() can send a datagram out of a specific
+    // interface - if not, multicasts are sent once, out of the interface
+    // that the system chooses
+    bool selectsInterfaces;
+
+    bool deferWrites;
+    QList<Datagram> ipv4Datagrams;
+    QList<Datagram> ipv6Datagrams;
+
+protected:
+
+    AbstractServer *const q;
+};
+
+}
+
+#endif // QMDNSENGINE_SERVERBASE_P_H
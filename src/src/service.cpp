@@ -22,6 +22,14 @@
  * IN THE SOFTWARE.
  */
 
+#include <algorithm>
+
+#include <QtGlobal>
+#if(QT_VERSION >= QT_VERSION_CHECK(5, 15, 0))
+#include <QRandomGenerator>
+#define USE_QRANDOMGENERATOR
+#endif
+
 #include <qmdnsengine/service.h>
 
 #include "service_p.h"
@@ -54,6 +62,8 @@ bool Service::operator==(const Service &other) const
     return d->type == other.d->type &&
         d->name == other.d->name &&
         d->port == other.d->port &&
+        d->targets == other.d->targets &&
+        d->addresses == other.d->addresses &&
         d->attributes == other.d->attributes;
 }
 
@@ -107,6 +117,71 @@ void Service::setPort(quint16 port)
     d->port = port;
 }
 
+QList<QHostAddress> Service::addresses() const
+{
+    return d->addresses;
+}
+
+void Service::setAddresses(const QList<QHostAddress> &addresses)
+{
+    d->addresses = addresses;
+}
+
+QList<Record> Service::targets() const
+{
+    return d->targets;
+}
+
+void Service::setTargets(const QList<Record> &targets)
+{
+    d->targets = targets;
+}
+
+QList<Record> Service::orderedTargets() const
+{
+    QList<Record> targets = d->targets;
+    std::stable_sort(targets.begin(), targets.end(), [](const Record &a, const Record &b) {
+        return a.priority() < b.priority();
+    });
+
+    // Within each priority, repeatedly pick a record at random with the
+    // chance of each being proportional to its weight (RFC 2782) - records
+    // with a weight of 0 are placed first so that they have a small chance
+    // of being picked
+
+    QList<Record> ordered;
+    while (!targets.isEmpty()) {
+        QList<Record> group;
+        const quint16 priority = targets.first().priority();
+        while (!targets.isEmpty() && targets.first().priority() == priority) {
+            Record record = targets.takeFirst();
+            if (record.weight()) {
+                group.append(record);
+            } else {
+                group.prepend(record);
+            }
+        }
+        while (!group.isEmpty()) {
+            // The sum of 16-bit weights fits comfortably in 32 bits
+            quint32 total = 0;
+            for (const Record &record : group) {
+                total += record.weight();
+            }
+#ifdef USE_QRANDOMGENERATOR
+            quint32 random = QRandomGenerator::global()->bounded(total + 1);
+#else
+            quint32 random = static_cast<quint32>(qrand()) % (total + 1);
+#endif
+            int index = 0;
+            for (quint32 sum = group.first().weight(); sum < random; sum += group.at(index).weight()) {
+                ++index;
+            }
+            ordered.append(group.takeAt(index));
+        }
+    }
+    return ordered;
+}
+
 QMap<QByteArray, QByteArray> Service::attributes() const
 {
     return d->attributes;
@@ -132,6 +207,7 @@ QDebug QMdnsEngine::operator<<(QDebug debug, const Service &service)
         << ", type: " << service.type()
         << ", hostname: " << service.hostname()
         << ", port: " << service.port()
+        << ", addresses: " << service.addresses()
         << ", attributes: " << service.attributes()
         << ")";
 
@@ -26,8 +26,12 @@
 #define QMDNSENGINE_SERVICE_P_H
 
 #include <QByteArray>
+#include <QHostAddress>
+#include <QList>
 #include <QMap>
 
+#include <qmdnsengine/record.h>
+
 namespace QMdnsEngine
 {
 
@@ -41,6 +45,8 @@ public:
     QByteArray name;
     QByteArray hostname;
     quint16 port;
+    QList<Record> targets;
+    QList<QHostAddress> addresses;
     QMap<QByteArray, QByteArray> attributes;
 };
 
@@ -0,0 +1,117 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <cstring>
+
+#include <QtGlobal>
+
+#ifdef Q_OS_LINUX
+
+#include <QHostAddress>
+#include <QNetworkInterface>
+
+#include "socketutil_p.h"
+
+namespace QMdnsEngine
+{
+
+quint16 sockaddrPort(const sockaddr_storage &storage)
+{
+    if (storage.ss_family == AF_INET) {
+        return ntohs(reinterpret_cast<const sockaddr_in*>(&storage)->sin_port);
+    } else {
+        return ntohs(reinterpret_cast<const sockaddr_in6*>(&storage)->sin6_port);
+    }
+}
+
+socklen_t toSockaddr(const QHostAddress &address, quint16 port, sockaddr_storage &storage)
+{
+    memset(&storage, 0, sizeof(sockaddr_storage));
+    if (address.protocol() == QAbstractSocket::IPv4Protocol) {
+        sockaddr_in *sin = reinterpret_cast<sockaddr_in*>(&storage);
+        sin->sin_family = AF_INET;
+        sin->sin_port = htons(port);
+        sin->sin_addr.s_addr = htonl(address.toIPv4Address());
+        return sizeof(sockaddr_in);
+    } else {
+        sockaddr_in6 *sin6 = reinterpret_cast<sockaddr_in6*>(&storage);
+        sin6->sin6_family = AF_INET6;
+        sin6->sin6_port = htons(port);
+        Q_IPV6ADDR ipv6Addr = address.toIPv6Address();
+        memcpy(&sin6->sin6_addr, &ipv6Addr, sizeof(Q_IPV6ADDR));
+
+        // The scope ID may either be an interface name or index
+        bool ok;
+        sin6->sin6_scope_id = address.scopeId().toUInt(&ok);
+        if (!ok) {
+            sin6->sin6_scope_id = QNetworkInterface::interfaceIndexFromName(address.scopeId());
+        }
+        return sizeof(sockaddr_in6);
+    }
+}
+
+int pktinfoIndex(msghdr &header)
+{
+    for (cmsghdr *cmsg = CMSG_FIRSTHDR(&header); cmsg; cmsg = CMSG_NXTHDR(&header, cmsg)) {
+        if (cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_PKTINFO) {
+            in_pktinfo info;
+            memcpy(&info, CMSG_DATA(cmsg), sizeof(in_pktinfo));
+            return info.ipi_ifindex;
+        }
+        if (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_PKTINFO) {
+            in6_pktinfo info;
+            memcpy(&info, CMSG_DATA(cmsg), sizeof(in6_pktinfo));
+            return info.ipi6_ifindex;
+        }
+    }
+    return 0;
+}
+
+socklen_t toPktinfo(QAbstractSocket::NetworkLayerProtocol protocol, int interfaceIndex, ControlBuffer &control)
+{
+    memset(&control, 0, sizeof(ControlBuffer));
+    if (protocol == QAbstractSocket::IPv4Protocol) {
+        in_pktinfo info;
+        memset(&info, 0, sizeof(in_pktinfo));
+        info.ipi_ifindex = interfaceIndex;
+        control.header.cmsg_level = IPPROTO_IP;
+        control.header.cmsg_type = IP_PKTINFO;
+        control.header.cmsg_len = CMSG_LEN(sizeof(in_pktinfo));
+        memcpy(CMSG_DATA(&control.header), &info, sizeof(in_pktinfo));
+        return CMSG_SPACE(sizeof(in_pktinfo));
+    } else {
+        in6_pktinfo info;
+        memset(&info, 0, sizeof(in6_pktinfo));
+        info.ipi6_ifindex = interfaceIndex;
+        control.header.cmsg_level = IPPROTO_IPV6;
+        control.header.cmsg_type = IPV6_PKTINFO;
+        control.header.cmsg_len = CMSG_LEN(sizeof(in6_pktinfo));
+        memcpy(CMSG_DATA(&control.header), &info, sizeof(in6_pktinfo));
+        return CMSG_SPACE(sizeof(in6_pktinfo));
+    }
+}
+
+}
+
+#endif
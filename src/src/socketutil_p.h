@@ -0,0 +1,62 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_SOCKETUTIL_P_H
+#define QMDNSENGINE_SOCKETUTIL_P_H
+
+#include <QtGlobal>
+
+#ifdef Q_OS_LINUX
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+#include <QAbstractSocket>
+
+class QHostAddress;
+
+namespace QMdnsEngine
+{
+
+// Helpers for the raw socket calls shared by the server implementations
+
+// Storage for an IP_PKTINFO or IPV6_PKTINFO control message
+union ControlBuffer
+{
+    cmsghdr header;
+    char data[CMSG_SPACE(sizeof(in6_pktinfo))];
+};
+
+quint16 sockaddrPort(const sockaddr_storage &storage);
+socklen_t toSockaddr(const QHostAddress &address, quint16 port, sockaddr_storage &storage);
+
+// Interface index from the IP_PKTINFO or IPV6_PKTINFO message, if present
+int pktinfoIndex(msghdr &header);
+socklen_t toPktinfo(QAbstractSocket::NetworkLayerProtocol protocol, int interfaceIndex, ControlBuffer &control);
+
+}
+
+#endif
+
+#endif // QMDNSENGINE_SOCKETUTIL_P_H
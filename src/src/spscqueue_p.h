@@ -0,0 +1,101 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_SPSCQUEUE_P_H
+#define QMDNSENGINE_SPSCQUEUE_P_H
+
+#include <utility>
+
+#include <QAtomicPointer>
+
+namespace QMdnsEngine
+{
+
+// Unbounded lock-free queue for exactly one producer thread and one consumer
+// thread; the head is always a placeholder node whose value has already been
+// taken (or was never set), which keeps the two ends from touching the same
+// node
+
+template<class T>
+class SpscQueue
+{
+    struct Node
+    {
+        Node() : next(nullptr) {}
+        explicit Node(const T &value) : value(value), next(nullptr) {}
+
+        T value;
+        QAtomicPointer<Node> next;
+    };
+
+public:
+
+    SpscQueue()
+        : head(new Node),
+          tail(head)
+    {
+    }
+
+    virtual ~SpscQueue()
+    {
+        while (head) {
+            Node *next = head->next.loadAcquire();
+            delete head;
+            head = next;
+        }
+    }
+
+    // Called from the producer thread only
+    void push(const T &value)
+    {
+        Node *node = new Node(value);
+        tail->next.storeRelease(node);
+        tail = node;
+    }
+
+    // Called from the consumer thread only
+    bool pop(T &value)
+    {
+        Node *next = head->next.loadAcquire();
+        if (!next) {
+            return false;
+        }
+        value = std::move(next->value);
+        delete head;
+        head = next;
+        return true;
+    }
+
+private:
+
+    SpscQueue(const SpscQueue &);
+    SpscQueue &operator=(const SpscQueue &);
+
+    Node *head;
+    Node *tail;
+};
+
+}
+
+#endif // QMDNSENGINE_SPSCQUEUE_P_H
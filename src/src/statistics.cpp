@@ -0,0 +1,100 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <qmdnsengine/statistics.h>
+
+#include "statistics_p.h"
+
+using namespace QMdnsEngine;
+
+Statistics::Statistics()
+    : d(new StatisticsPrivate)
+{
+}
+
+Statistics::Statistics(const Statistics &other)
+    : d(new StatisticsPrivate)
+{
+    *this = other;
+}
+
+Statistics &Statistics::operator=(const Statistics &other)
+{
+    *d = *other.d;
+    return *this;
+}
+
+Statistics::~Statistics()
+{
+    delete d;
+}
+
+QList<QByteArray> Statistics::names() const
+{
+    QList<QByteArray> names;
+    for (const auto &value : d->values) {
+        names.append(value.first);
+    }
+    return names;
+}
+
+quint64 Statistics::value(const QByteArray &name) const
+{
+    for (const auto &value : d->values) {
+        if (value.first == name) {
+            return value.second;
+        }
+    }
+    return 0;
+}
+
+void Statistics::setValue(const QByteArray &name, quint64 value)
+{
+    for (auto &existing : d->values) {
+        if (existing.first == name) {
+            existing.second = value;
+            return;
+        }
+    }
+    d->values.append(qMakePair(name, value));
+}
+
+Statistics &Statistics::operator+=(const Statistics &other)
+{
+    for (const auto &value : other.d->values) {
+        setValue(value.first, this->value(value.first) + value.second);
+    }
+    return *this;
+}
+
+QByteArray Statistics::toPrometheus(const QByteArray &prefix) const
+{
+    QByteArray output;
+    for (const auto &value : d->values) {
+        QByteArray metric = prefix + "_" + value.first + "_total";
+        output.append("# TYPE " + metric + " counter\n");
+        output.append(metric + " " + QByteArray::number(value.second) + "\n");
+    }
+    return output;
+}
@@ -0,0 +1,118 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QDateTime>
+
+#include "timer_p.h"
+
+namespace QMdnsEngine
+{
+
+qint64 currentTime(AbstractClock *clock)
+{
+    return clock ? clock->elapsed() : QDateTime::currentMSecsSinceEpoch();
+}
+
+}
+
+using namespace QMdnsEngine;
+
+Timer::Timer(QObject *parent)
+    : QObject(parent),
+      interval(0),
+      singleShot(false),
+      id(0)
+{
+    connect(&timer, &QTimer::timeout, this, &Timer::timeout);
+}
+
+Timer::~Timer()
+{
+    stop();
+}
+
+void Timer::setClock(AbstractClock *newClock)
+{
+    stop();
+    clock = newClock;
+}
+
+void Timer::setInterval(int msec)
+{
+    interval = msec;
+    timer.setInterval(msec);
+}
+
+void Timer::setSingleShot(bool newSingleShot)
+{
+    singleShot = newSingleShot;
+    timer.setSingleShot(newSingleShot);
+}
+
+bool Timer::isActive() const
+{
+    return clock ? id != 0 : timer.isActive();
+}
+
+void Timer::start()
+{
+    start(interval);
+}
+
+void Timer::start(int msec)
+{
+    // As with QTimer, starting an active timer restarts it
+    setInterval(msec);
+    if (clock) {
+        stop();
+        id = clock->schedule(msec, [this]() {
+            onScheduled();
+        });
+    } else {
+        timer.start(msec);
+    }
+}
+
+void Timer::stop()
+{
+    if (clock) {
+        if (id) {
+            clock->cancel(id);
+            id = 0;
+        }
+    } else {
+        timer.stop();
+    }
+}
+
+void Timer::onScheduled()
+{
+    id = 0;
+    if (!singleShot) {
+        id = clock->schedule(interval, [this]() {
+            onScheduled();
+        });
+    }
+    emit timeout();
+}
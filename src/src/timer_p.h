@@ -0,0 +1,80 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef QMDNSENGINE_TIMER_P_H
+#define QMDNSENGINE_TIMER_P_H
+
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+
+#include <qmdnsengine/abstractclock.h>
+
+namespace QMdnsEngine
+{
+
+// Current time in milliseconds according to the clock (if one is provided)
+// or the system clock
+qint64 currentTime(AbstractClock *clock);
+
+// Timer with the same interface as QTimer that runs on a clock when one is
+// provided and is otherwise an ordinary QTimer
+
+class Timer : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    explicit Timer(QObject *parent = 0);
+    virtual ~Timer();
+
+    void setClock(AbstractClock *clock);
+
+    void setInterval(int msec);
+    void setSingleShot(bool singleShot);
+    bool isActive() const;
+
+    void start();
+    void start(int msec);
+    void stop();
+
+Q_SIGNALS:
+
+    void timeout();
+
+private:
+
+    void onScheduled();
+
+    QTimer timer;
+    QPointer<AbstractClock> clock;
+    int interval;
+    bool singleShot;
+    int id;
+};
+
+}
+
+#endif // QMDNSENGINE_TIMER_P_H
@@ -0,0 +1,184 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QObject>
+#include <QTest>
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/histogram.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
+
+#include "common/testserver.h"
+
+const QByteArray Type = "_test._tcp.local.";
+const QByteArray Fqdn = "Test." + Type;
+const QByteArray Other = "Other._other._tcp.local.";
+const QByteArray Target = "Test.local.";
+
+class TestAbstractServer : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void testSubscribe();
+    void testSubscribeSuffix();
+    void testUnsubscribe();
+    void testResponderLimit();
+};
+
+static QMdnsEngine::Record createRecord(const QByteArray &name, quint16 type, const QByteArray &target = QByteArray())
+{
+    QMdnsEngine::Record record;
+    record.setName(name);
+    record.setType(type);
+    record.setTarget(target);
+    return record;
+}
+
+void TestAbstractServer::testSubscribe()
+{
+    TestServer server;
+    QObject receiver;
+    QList<QMdnsEngine::Message> messages;
+    server.setMessageHandler(&receiver, [&messages](const QMdnsEngine::Message &received) {
+        messages.append(received);
+    });
+    server.subscribe(&receiver, Target, QMdnsEngine::A);
+
+    // Only the matching query should be delivered
+    QMdnsEngine::Query query;
+    query.setName(Target);
+    query.setType(QMdnsEngine::A);
+    QMdnsEngine::Message message;
+    message.addQuery(query);
+    query.setType(QMdnsEngine::AAAA);
+    message.addQuery(query);
+    query.setName(Fqdn);
+    query.setType(QMdnsEngine::A);
+    message.addQuery(query);
+    server.deliverMessage(message);
+
+    QCOMPARE(messages.count(), 1);
+    QCOMPARE(messages.at(0).queries().count(), 1);
+    QCOMPARE(messages.at(0).queries().at(0).type(), static_cast<quint16>(QMdnsEngine::A));
+
+    // A message without a match should not be delivered
+    messages.clear();
+    QMdnsEngine::Message otherMessage;
+    otherMessage.setResponse(true);
+    otherMessage.addRecord(createRecord(Other, QMdnsEngine::SRV, Target));
+    server.deliverMessage(otherMessage);
+    QCOMPARE(messages.count(), 0);
+}
+
+void TestAbstractServer::testSubscribeSuffix()
+{
+    TestServer server;
+    QObject receiver;
+    QList<QMdnsEngine::Message> messages;
+    server.setMessageHandler(&receiver, [&messages](const QMdnsEngine::Message &received) {
+        messages.append(received);
+    });
+    server.subscribeSuffix(&receiver, Type, QMdnsEngine::SRV);
+
+    // The SRV record in the domain should be delivered along with the
+    // address record for its target
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    message.addRecord(createRecord(Other, QMdnsEngine::SRV, Target));
+    message.addRecord(createRecord(Fqdn, QMdnsEngine::SRV, Target));
+    message.addRecord(createRecord(Fqdn, QMdnsEngine::TXT));
+    message.addRecord(createRecord(Target, QMdnsEngine::A));
+    server.deliverMessage(message);
+
+    QCOMPARE(messages.count(), 1);
+    QVERIFY(messages.at(0).isResponse());
+    const auto records = messages.at(0).records();
+    QCOMPARE(records.count(), 2);
+    QCOMPARE(records.at(0).name(), Fqdn);
+    QCOMPARE(records.at(0).type(), static_cast<quint16>(QMdnsEngine::SRV));
+    QCOMPARE(records.at(1).name(), Target);
+    QCOMPARE(records.at(1).type(), static_cast<quint16>(QMdnsEngine::A));
+}
+
+void TestAbstractServer::testUnsubscribe()
+{
+    TestServer server;
+    QList<QMdnsEngine::Message> messages;
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    message.addRecord(createRecord(Target, QMdnsEngine::A));
+
+    // Explicitly remove the subscription
+    {
+        QObject receiver;
+        server.setMessageHandler(&receiver, [&messages](const QMdnsEngine::Message &received) {
+            messages.append(received);
+        });
+        server.subscribe(&receiver, Target, QMdnsEngine::ANY);
+        server.deliverMessage(message);
+        QCOMPARE(messages.count(), 1);
+        server.unsubscribe(&receiver, Target, QMdnsEngine::ANY);
+        server.deliverMessage(message);
+        QCOMPARE(messages.count(), 1);
+
+        // Leave a subscription in place for the receiver to be destroyed with
+        server.subscribe(&receiver, Target, QMdnsEngine::A);
+    }
+
+    // The subscription should be gone along with the receiver
+    server.deliverMessage(message);
+    QCOMPARE(messages.count(), 1);
+}
+
+void TestAbstractServer::testResponderLimit()
+{
+    TestServer server;
+    auto responder = [](int i) {
+        return QHostAddress(QString("10.0.%1.%2").arg(i / 256).arg(i % 256));
+    };
+
+    // Only the 256 responders that answered most recently are kept; the
+    // first one answers again and so stays while the second is dropped
+    server.recordLatency(QMdnsEngine::AbstractServer::ResponseLatency, 10, responder(0));
+    for (int i = 1; i < 300; ++i) {
+        server.recordLatency(QMdnsEngine::AbstractServer::ResponseLatency, 10, responder(i));
+        if (i == 200) {
+            server.recordLatency(QMdnsEngine::AbstractServer::ResponseLatency, 20, responder(0));
+        }
+    }
+    QCOMPARE(server.responders().count(), 256);
+    QCOMPARE(server.responseLatency(responder(0)).count(), 2ull);
+    QCOMPARE(server.responseLatency(responder(1)).count(), 0ull);
+    QCOMPARE(server.responseLatency(responder(299)).count(), 1ull);
+
+    // All of the latencies are still counted in the overall histogram
+    QCOMPARE(server.latency(QMdnsEngine::AbstractServer::ResponseLatency).count(), 301ull);
+}
+
+QTEST_MAIN(TestAbstractServer)
+#include "TestAbstractServer.moc"
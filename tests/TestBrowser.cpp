@@ -26,12 +26,15 @@
 #include <QTest>
 
 #include <qmdnsengine/browser.h>
+#include <qmdnsengine/cache.h>
 #include <qmdnsengine/dns.h>
+#include <qmdnsengine/manualclock.h>
 #include <qmdnsengine/mdns.h>
 #include <qmdnsengine/message.h>
 #include <qmdnsengine/query.h>
 #include <qmdnsengine/record.h>
 #include <qmdnsengine/service.h>
+#include <qmdnsengine/statistics.h>
 
 #include "common/testserver.h"
 #include "common/util.h"
@@ -40,6 +43,7 @@ Q_DECLARE_METATYPE(QMdnsEngine::Service)
 
 const QByteArray Name = "Test";
 const QByteArray Type = "_test._tcp.local.";
+const QByteArray Type2 = "_test2._tcp.local.";
 const QByteArray Fqdn = Name + "." + Type;
 const QByteArray Target = "Test.local.";
 const quint16 Port = 1234;
@@ -54,7 +58,20 @@ private Q_SLOTS:
 
     void initTestCase();
     void testBrowser();
+    void testAddressAnnouncements();
     void testBrowsePtr();
+    void testBackoff();
+    void testShared();
+    void testMultipleTypes();
+    void testMultipleTargets();
+    void testResolveAddresses();
+    void testKnownAnswers();
+    void testKnownAnswerBudget();
+    void testPassive();
+    void testBatches();
+    void testGoodbye();
+    void testSharedTargets();
+    void testStatistics();
 };
 
 void TestBrowser::initTestCase()
@@ -145,6 +162,43 @@ void TestBrowser::testBrowser()
     QCOMPARE(serviceRemovedSpy.count(), 1);
 }
 
+void TestBrowser::testAddressAnnouncements()
+{
+    TestServer server;
+    QMdnsEngine::Cache cache;
+    QMdnsEngine::Browser browser(&server, Type, &cache);
+    QSignalSpy serviceAddedSpy(&browser, SIGNAL(serviceAdded(Service)));
+
+    // Transmit the PTR and SRV records without any addresses
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    QMdnsEngine::Record record;
+    record.setName(Type);
+    record.setType(QMdnsEngine::PTR);
+    record.setTarget(Fqdn);
+    message.addRecord(record);
+    record.setName(Fqdn);
+    record.setType(QMdnsEngine::SRV);
+    record.setTarget(Target);
+    record.setPort(Port);
+    message.addRecord(record);
+    server.deliverMessage(message);
+    QCOMPARE(serviceAddedSpy.count(), 1);
+
+    // The browser subscribes to the addresses of the new host as soon as it
+    // is known, so a separate announcement of its address should be cached
+    message = QMdnsEngine::Message();
+    message.setResponse(true);
+    record = QMdnsEngine::Record();
+    record.setName(Target);
+    record.setType(QMdnsEngine::A);
+    record.setAddress(QHostAddress("192.168.1.1"));
+    message.addRecord(record);
+    server.deliverMessage(message);
+    QVERIFY(cache.lookupRecord(Target, QMdnsEngine::A, record));
+    QCOMPARE(record.address(), QHostAddress("192.168.1.1"));
+}
+
 void TestBrowser::testBrowsePtr()
 {
     TestServer server;
@@ -168,5 +222,534 @@ void TestBrowser::testBrowsePtr()
     QTRY_VERIFY(queryReceived(&server, Type, QMdnsEngine::PTR));
 }
 
+void TestBrowser::testBackoff()
+{
+    QMdnsEngine::ManualClock clock;
+    TestServer server;
+    server.setClock(&clock);
+    QMdnsEngine::Browser browser(&server, Type);
+
+    // The first query is immediate and the interval then doubles
+    QVERIFY(queryReceived(&server, Type, QMdnsEngine::PTR));
+    server.clearReceivedMessages();
+    const QList<int> intervals = {1000, 2000, 4000, 8000};
+    for (int interval : intervals) {
+        clock.advance(interval - 1);
+        QVERIFY(!queryReceived(&server, Type, QMdnsEngine::PTR));
+        clock.advance(1);
+        QVERIFY(queryReceived(&server, Type, QMdnsEngine::PTR));
+        server.clearReceivedMessages();
+    }
+
+    // A change in the network interfaces starts over
+    emit server.interfacesChanged();
+    clock.advance(1000);
+    QVERIFY(queryReceived(&server, Type, QMdnsEngine::PTR));
+
+    // Another browser for the type combines its bounds with the first: the
+    // smallest minimum and the smallest maximum apply
+    QMdnsEngine::Browser other(&server, Type);
+    browser.setQueryInterval(4000, 4000);
+    other.setQueryInterval(2000, 60 * 1000);
+    server.clearReceivedMessages();
+    const QList<int> combined = {2000, 4000, 4000};
+    for (int interval : combined) {
+        clock.advance(interval - 1);
+        QVERIFY(!queryReceived(&server, Type, QMdnsEngine::PTR));
+        clock.advance(1);
+        QVERIFY(queryReceived(&server, Type, QMdnsEngine::PTR));
+        server.clearReceivedMessages();
+    }
+}
+
+void TestBrowser::testShared()
+{
+    TestServer server;
+    QMdnsEngine::Browser browser1(&server, Type);
+    QMdnsEngine::Browser browser2(&server, Type);
+    QSignalSpy serviceAddedSpy1(&browser1, SIGNAL(serviceAdded(Service)));
+    QSignalSpy serviceAddedSpy2(&browser2, SIGNAL(serviceAdded(Service)));
+
+    // Only one query should have been sent for both browsers
+    int queries = 0;
+    const auto messages = server.receivedMessages();
+    for (const QMdnsEngine::Message &message : messages) {
+        queries += message.queries().count();
+    }
+    QCOMPARE(queries, 1);
+
+    // Transmit the PTR and SRV records
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    QMdnsEngine::Record record;
+    record.setName(Type);
+    record.setType(QMdnsEngine::PTR);
+    record.setTarget(Fqdn);
+    message.addRecord(record);
+    record.setName(Fqdn);
+    record.setType(QMdnsEngine::SRV);
+    record.setTarget(Target);
+    record.setPort(Port);
+    message.addRecord(record);
+    server.deliverMessage(message);
+
+    // Both browsers should report the service
+    QCOMPARE(serviceAddedSpy1.count(), 1);
+    QCOMPARE(serviceAddedSpy2.count(), 1);
+
+    // A browser created later should report it as well
+    QMdnsEngine::Browser browser3(&server, Type);
+    QSignalSpy serviceAddedSpy3(&browser3, SIGNAL(serviceAdded(Service)));
+    QTRY_COMPARE(serviceAddedSpy3.count(), 1);
+}
+
+void TestBrowser::testMultipleTypes()
+{
+    TestServer server;
+    QMdnsEngine::Browser browser(&server, {Type, Type2});
+    QSignalSpy serviceAddedSpy(&browser, SIGNAL(serviceAdded(Service)));
+
+    // Both questions should have been sent in a single message
+    QCOMPARE(server.receivedMessages().count(), 1);
+    QCOMPARE(server.receivedMessages().at(0).queries().count(), 2);
+
+    // Transmit the PTR and SRV records for the second type
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    QMdnsEngine::Record record;
+    record.setName(Type2);
+    record.setType(QMdnsEngine::PTR);
+    record.setTarget(Name + "." + Type2);
+    message.addRecord(record);
+    record.setName(Name + "." + Type2);
+    record.setType(QMdnsEngine::SRV);
+    record.setTarget(Target);
+    record.setPort(Port);
+    message.addRecord(record);
+    server.deliverMessage(message);
+
+    // The service should be reported with its type
+    QCOMPARE(serviceAddedSpy.count(), 1);
+    QCOMPARE(serviceAddedSpy.at(0).at(0).value<QMdnsEngine::Service>().type(), Type2);
+}
+
+void TestBrowser::testMultipleTargets()
+{
+    TestServer server;
+    QMdnsEngine::Browser browser(&server, Type);
+    QSignalSpy serviceAddedSpy(&browser, SIGNAL(serviceAdded(Service)));
+
+    // Transmit the PTR record and SRV records for two hosts
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    QMdnsEngine::Record record;
+    record.setName(Type);
+    record.setType(QMdnsEngine::PTR);
+    record.setTarget(Fqdn);
+    message.addRecord(record);
+    record.setName(Fqdn);
+    record.setType(QMdnsEngine::SRV);
+    record.setTarget("backup.local.");
+    record.setPort(Port);
+    record.setPriority(1);
+    message.addRecord(record);
+    record.setTarget(Target);
+    record.setPriority(0);
+    message.addRecord(record);
+    server.deliverMessage(message);
+
+    // The service should include both targets and prefer the one with the
+    // lowest priority
+    QCOMPARE(serviceAddedSpy.count(), 1);
+    QMdnsEngine::Service service = serviceAddedSpy.at(0).at(0).value<QMdnsEngine::Service>();
+    QCOMPARE(service.targets().count(), 2);
+    QCOMPARE(service.hostname(), Target);
+    const QList<QMdnsEngine::Record> targets = service.orderedTargets();
+    QCOMPARE(targets.count(), 2);
+    QCOMPARE(targets.at(0).target(), Target);
+    QCOMPARE(targets.at(1).target(), QByteArray("backup.local."));
+}
+
+void TestBrowser::testResolveAddresses()
+{
+    QMdnsEngine::ManualClock clock;
+    TestServer server;
+    server.setClock(&clock);
+    QMdnsEngine::Browser browser(&server, Type);
+    browser.setResolveAddresses(true, 1000);
+    QSignalSpy serviceAddedSpy(&browser, SIGNAL(serviceAdded(Service)));
+
+    // Transmit the PTR and SRV records without an address
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    QMdnsEngine::Record record;
+    record.setName(Type);
+    record.setType(QMdnsEngine::PTR);
+    record.setTarget(Fqdn);
+    message.addRecord(record);
+    record.setName(Fqdn);
+    record.setType(QMdnsEngine::SRV);
+    record.setTarget(Target);
+    record.setPort(Port);
+    message.addRecord(record);
+    server.deliverMessage(message);
+
+    // The browser should ask for the address instead of reporting the service
+    QCOMPARE(serviceAddedSpy.count(), 0);
+    QVERIFY(queryReceived(&server, Target, QMdnsEngine::A));
+
+    // Once the address arrives, the service should be reported with it
+    QMdnsEngine::Message addressMessage;
+    addressMessage.setResponse(true);
+    QMdnsEngine::Record addressRecord;
+    addressRecord.setName(Target);
+    addressRecord.setType(QMdnsEngine::A);
+    addressRecord.setAddress(QHostAddress("127.0.0.1"));
+    addressMessage.addRecord(addressRecord);
+    server.deliverMessage(addressMessage);
+    QCOMPARE(serviceAddedSpy.count(), 1);
+    QCOMPARE(serviceAddedSpy.at(0).at(0).value<QMdnsEngine::Service>().addresses(),
+             QList<QHostAddress>({QHostAddress("127.0.0.1")}));
+
+    // A service whose address never arrives is reported after the timeout
+    record.setName(Type);
+    record.setType(QMdnsEngine::PTR);
+    record.setTarget(Name + "2." + Type);
+    message = QMdnsEngine::Message();
+    message.setResponse(true);
+    message.addRecord(record);
+    record.setName(Name + "2." + Type);
+    record.setType(QMdnsEngine::SRV);
+    record.setTarget("other.local.");
+    message.addRecord(record);
+    server.deliverMessage(message);
+    clock.advance(999);
+    QCOMPARE(serviceAddedSpy.count(), 1);
+    clock.advance(1);
+    QCOMPARE(serviceAddedSpy.count(), 2);
+}
+
+void TestBrowser::testKnownAnswers()
+{
+    QMdnsEngine::ManualClock clock;
+    TestServer server;
+    server.setClock(&clock);
+    QMdnsEngine::Browser browser(&server, Type);
+    Q_UNUSED(browser);
+
+    // Transmit a PTR record that lives for ten seconds
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    QMdnsEngine::Record record;
+    record.setName(Type);
+    record.setType(QMdnsEngine::PTR);
+    record.setTarget(Fqdn);
+    record.setTtl(10);
+    message.addRecord(record);
+    server.deliverMessage(message);
+    server.clearReceivedMessages();
+
+    // Find the known answers included with the last query for the type
+    auto knownAnswers = [&server]() {
+        QList<QMdnsEngine::Record> records;
+        const auto messages = server.receivedMessages();
+        for (const QMdnsEngine::Message &message : messages) {
+            if (!message.isResponse() && message.queries().count() &&
+                    message.queries().at(0).name() == Type) {
+                records = message.records();
+            }
+        }
+        return records;
+    };
+
+    // The next query carries the record with the time it has left
+    clock.advance(1000);
+    QList<QMdnsEngine::Record> records = knownAnswers();
+    QCOMPARE(records.count(), 1);
+    QCOMPARE(records.at(0).target(), Fqdn);
+    QCOMPARE(records.at(0).ttl(), 9u);
+
+    // Once less than half of its TTL remains, the record is left out so
+    // that responders refresh it
+    server.clearReceivedMessages();
+    clock.advance(6000);
+    QVERIFY(queryReceived(&server, Type, QMdnsEngine::PTR));
+    QCOMPARE(knownAnswers().count(), 0);
+}
+
+void TestBrowser::testKnownAnswerBudget()
+{
+    QMdnsEngine::ManualClock clock;
+    TestServer server;
+    server.setClock(&clock);
+    QMdnsEngine::Browser browser(&server, Type);
+
+    // Transmit far more PTR records than fit in a single query; each one
+    // takes 35 bytes when measured on its own
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    for (int i = 0; i < 100; ++i) {
+        QMdnsEngine::Record record;
+        record.setName(Type);
+        record.setType(QMdnsEngine::PTR);
+        record.setTarget("S" + QByteArray::number(100 + i) + "." + Type);
+        record.setTtl(120);
+        message.addRecord(record);
+    }
+    server.deliverMessage(message);
+    server.clearReceivedMessages();
+
+    // The 34 bytes of the query leave room for 40 of the answers in the
+    // default budget of 1440 bytes and the rest are counted as omitted
+    clock.advance(1000);
+    QList<QMdnsEngine::Record> records;
+    const auto messages = server.receivedMessages();
+    for (const QMdnsEngine::Message &message : messages) {
+        if (!message.isResponse() && message.queries().count() &&
+                message.queries().at(0).name() == Type) {
+            records = message.records();
+        }
+    }
+    QCOMPARE(records.count(), 40);
+    QCOMPARE(QMdnsEngine::Browser::sharedStatistics(&server).value("known_answers_omitted"), 60ull);
+}
+
+void TestBrowser::testPassive()
+{
+    QMdnsEngine::ManualClock clock;
+    TestServer server;
+    server.setClock(&clock);
+    QMdnsEngine::Browser browser(&server, Type, QMdnsEngine::Browser::Passive);
+    QSignalSpy serviceAddedSpy(&browser, SIGNAL(serviceAdded(Service)));
+
+    // An overheard announcement should still be reported
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    QMdnsEngine::Record record;
+    record.setName(Type);
+    record.setType(QMdnsEngine::PTR);
+    record.setTarget(Fqdn);
+    record.setTtl(10);
+    message.addRecord(record);
+    record.setName(Fqdn);
+    record.setType(QMdnsEngine::SRV);
+    record.setTarget(Target);
+    record.setPort(Port);
+    message.addRecord(record);
+    server.deliverMessage(message);
+    QCOMPARE(serviceAddedSpy.count(), 1);
+
+    // Nothing should be sent, including refreshes of the expiring records
+    clock.advance(20 * 1000);
+    QCOMPARE(server.receivedMessages().count(), 0);
+
+    // An active browser for another type should not refresh the records
+    {
+        QMdnsEngine::Browser other(&server, Type2);
+        Q_UNUSED(other);
+        server.deliverMessage(message);
+        clock.advance(10 * 1000);
+        QVERIFY(queryReceived(&server, Type2, QMdnsEngine::PTR));
+        QVERIFY(!queryReceived(&server, Type, QMdnsEngine::PTR));
+        QVERIFY(!queryReceived(&server, Fqdn, QMdnsEngine::SRV));
+    }
+    server.clearReceivedMessages();
+
+    // An active browser for the same type resumes querying
+    QMdnsEngine::Browser active(&server, Type);
+    Q_UNUSED(active);
+    QVERIFY(queryReceived(&server, Type, QMdnsEngine::PTR));
+}
+
+void TestBrowser::testBatches()
+{
+    TestServer server;
+    QMdnsEngine::Browser browser(&server, Type);
+    QList<QList<QMdnsEngine::Service>> added;
+    QSignalSpy serviceAddedSpy(&browser, SIGNAL(serviceAdded(Service)));
+    connect(&browser, &QMdnsEngine::Browser::servicesAdded, [&added](const QList<QMdnsEngine::Service> &services) {
+        added.append(services);
+    });
+
+    // Transmit two services in a single message
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    const QList<QByteArray> names = {"Test1", "Test2"};
+    for (const QByteArray &name : names) {
+        QMdnsEngine::Record record;
+        record.setName(Type);
+        record.setType(QMdnsEngine::PTR);
+        record.setTarget(name + "." + Type);
+        message.addRecord(record);
+        record.setName(name + "." + Type);
+        record.setType(QMdnsEngine::SRV);
+        record.setTarget(Target);
+        record.setPort(Port);
+        message.addRecord(record);
+    }
+    server.deliverMessage(message);
+
+    // Both should be reported individually and then in a single batch
+    QCOMPARE(serviceAddedSpy.count(), 2);
+    QCOMPARE(added.count(), 1);
+    QCOMPARE(added.at(0).count(), 2);
+
+    // The snapshot should hold both services
+    QList<QMdnsEngine::Service> services = browser.services();
+    QCOMPARE(services.count(), 2);
+    QCOMPARE(services.at(0).name(), QByteArray("Test1"));
+    QCOMPARE(services.at(1).name(), QByteArray("Test2"));
+}
+
+void TestBrowser::testGoodbye()
+{
+    TestServer server;
+    QMdnsEngine::Browser browser(&server, Type);
+    QSignalSpy serviceAddedSpy(&browser, SIGNAL(serviceAdded(Service)));
+    QSignalSpy serviceRemovedSpy(&browser, SIGNAL(serviceRemoved(Service)));
+
+    QMdnsEngine::Record ptrRecord;
+    ptrRecord.setName(Type);
+    ptrRecord.setType(QMdnsEngine::PTR);
+    ptrRecord.setTarget(Fqdn);
+    QMdnsEngine::Record srvRecord;
+    srvRecord.setName(Fqdn);
+    srvRecord.setType(QMdnsEngine::SRV);
+    srvRecord.setTarget(Target);
+    srvRecord.setPort(Port);
+
+    // Announce the service and then say goodbye to it
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    message.addRecord(ptrRecord);
+    message.addRecord(srvRecord);
+    server.deliverMessage(message);
+    QCOMPARE(serviceAddedSpy.count(), 1);
+    ptrRecord.setTtl(0);
+    srvRecord.setTtl(0);
+    message = QMdnsEngine::Message();
+    message.setResponse(true);
+    message.addRecord(ptrRecord);
+    message.addRecord(srvRecord);
+    server.deliverMessage(message);
+    QCOMPARE(serviceRemovedSpy.count(), 1);
+
+    // A SRV record on its own should not bring the service back, since no
+    // PTR record refers to it any longer
+    srvRecord.setTtl(120);
+    message = QMdnsEngine::Message();
+    message.setResponse(true);
+    message.addRecord(srvRecord);
+    server.deliverMessage(message);
+    QCOMPARE(serviceAddedSpy.count(), 1);
+}
+
+void TestBrowser::testSharedTargets()
+{
+    TestServer server;
+    QMdnsEngine::Cache cache;
+    QMdnsEngine::Browser browser(&server, Type, &cache);
+    QSignalSpy serviceAddedSpy(&browser, SIGNAL(serviceAdded(Service)));
+    QSignalSpy serviceUpdatedSpy(&browser, SIGNAL(serviceUpdated(Service)));
+
+    // Announce an address for the host and check that it was kept
+    auto announceAddress = [&server, &cache](const QHostAddress &address) {
+        QMdnsEngine::Message message;
+        message.setResponse(true);
+        QMdnsEngine::Record record;
+        record.setName(Target);
+        record.setType(QMdnsEngine::A);
+        record.setAddress(address);
+        message.addRecord(record);
+        server.deliverMessage(message);
+        QList<QMdnsEngine::Record> records;
+        cache.lookupRecords(Target, QMdnsEngine::A, records);
+        for (const QMdnsEngine::Record &cached : records) {
+            if (cached.address() == address) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    QMdnsEngine::Record ptrRecord;
+    ptrRecord.setName(Type);
+    ptrRecord.setType(QMdnsEngine::PTR);
+    ptrRecord.setTarget(Fqdn);
+    QMdnsEngine::Record srvRecord;
+    srvRecord.setName(Fqdn);
+    srvRecord.setType(QMdnsEngine::SRV);
+    srvRecord.setTarget(Target);
+    srvRecord.setPort(Port);
+    srvRecord.setFlushCache(true);
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    message.addRecord(ptrRecord);
+    message.addRecord(srvRecord);
+    server.deliverMessage(message);
+    QCOMPARE(serviceAddedSpy.count(), 1);
+    QVERIFY(announceAddress(QHostAddress("192.168.1.1")));
+
+    // Moving the service to another port on the same host should keep the
+    // subscription to the addresses of the host
+    srvRecord.setPort(Port + 1);
+    message = QMdnsEngine::Message();
+    message.setResponse(true);
+    message.addRecord(srvRecord);
+    server.deliverMessage(message);
+    QCOMPARE(serviceUpdatedSpy.count(), 1);
+    QVERIFY(announceAddress(QHostAddress("192.168.1.2")));
+
+    // Add a second SRV record for the same host and then say goodbye to
+    // it; the first one still refers to the host
+    QMdnsEngine::Record secondRecord = srvRecord;
+    secondRecord.setPort(Port + 2);
+    secondRecord.setPriority(1);
+    secondRecord.setFlushCache(false);
+    message = QMdnsEngine::Message();
+    message.setResponse(true);
+    message.addRecord(secondRecord);
+    server.deliverMessage(message);
+    QCOMPARE(serviceUpdatedSpy.count(), 2);
+    secondRecord.setTtl(0);
+    message = QMdnsEngine::Message();
+    message.setResponse(true);
+    message.addRecord(secondRecord);
+    server.deliverMessage(message);
+    QCOMPARE(serviceUpdatedSpy.count(), 3);
+    QVERIFY(announceAddress(QHostAddress("192.168.1.3")));
+}
+
+void TestBrowser::testStatistics()
+{
+    TestServer server;
+    QMdnsEngine::Browser browser1(&server, Type);
+    QMdnsEngine::Browser browser2(&server, Type);
+
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    QMdnsEngine::Record record;
+    record.setName(Type);
+    record.setType(QMdnsEngine::PTR);
+    record.setTarget(Fqdn);
+    message.addRecord(record);
+    record.setName(Fqdn);
+    record.setType(QMdnsEngine::SRV);
+    record.setTarget(Target);
+    record.setPort(Port);
+    message.addRecord(record);
+    server.deliverMessage(message);
+
+    // Each browser counts the services it reported
+    QCOMPARE(browser1.statistics().value("services_added"), 1ull);
+    QCOMPARE(browser2.statistics().value("services_added"), 1ull);
+    QCOMPARE(browser1.statistics().value("responses_received"), 0ull);
+
+    // The query and the response are shared, so they are counted once
+    QMdnsEngine::Statistics statistics = QMdnsEngine::Browser::sharedStatistics(&server);
+    QCOMPARE(statistics.value("queries_sent"), 1ull);
+    QCOMPARE(statistics.value("responses_received"), 1ull);
+}
+
 QTEST_MAIN(TestBrowser)
 #include "TestBrowser.moc"
@@ -28,6 +28,7 @@
 
 #include <qmdnsengine/dns.h>
 #include <qmdnsengine/cache.h>
+#include <qmdnsengine/manualclock.h>
 #include <qmdnsengine/record.h>
 
 Q_DECLARE_METATYPE(QMdnsEngine::Record)
@@ -49,6 +50,8 @@ private Q_SLOTS:
     void testExpiry();
     void testRemoval();
     void testCacheFlush();
+    void testClock();
+    void testRemaining();
 
 private:
 
@@ -123,6 +126,53 @@ void TestCache::testCacheFlush()
     QCOMPARE(records.length(), 1);
 }
 
+void TestCache::testClock()
+{
+    QMdnsEngine::ManualClock clock;
+    QMdnsEngine::Cache cache;
+    cache.setClock(&clock);
+
+    QMdnsEngine::Record record = createRecord();
+    record.setTtl(60 * 60);
+    cache.addRecord(record);
+
+    QSignalSpy shouldQuerySpy(&cache, SIGNAL(shouldQuery(Record)));
+    QSignalSpy recordExpiredSpy(&cache, SIGNAL(recordExpired(Record)));
+
+    // Nothing should happen until half of the TTL (plus up to 20 ms) has
+    // passed
+    clock.advance(29 * 60 * 1000);
+    QCOMPARE(shouldQuerySpy.count(), 0);
+    clock.advance(61 * 1000);
+    QCOMPARE(shouldQuerySpy.count(), 1);
+
+    // The record should expire after the full hour
+    clock.advance(30 * 60 * 1000);
+    QCOMPARE(shouldQuerySpy.count(), 4);
+    QCOMPARE(recordExpiredSpy.count(), 1);
+    QVERIFY(!cache.lookupRecord(Name, Type, record));
+}
+
+void TestCache::testRemaining()
+{
+    QMdnsEngine::ManualClock clock;
+    QMdnsEngine::Cache cache;
+    cache.setClock(&clock);
+
+    QMdnsEngine::Record record = createRecord();
+    record.setTtl(10);
+    cache.addRecord(record);
+
+    // The remaining time counts down while the TTL is left unchanged
+    clock.advance(4000);
+    QList<QMdnsEngine::Record> records;
+    QList<qint64> remaining;
+    QVERIFY(cache.lookupRecords(Name, Type, records, remaining));
+    QCOMPARE(records.length(), 1);
+    QCOMPARE(records.at(0).ttl(), 10u);
+    QCOMPARE(remaining.at(0), static_cast<qint64>(6000));
+}
+
 QMdnsEngine::Record TestCache::createRecord()
 {
     QMdnsEngine::Record record;
@@ -28,6 +28,8 @@
 #include <QTest>
 
 #include <qmdnsengine/dns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/query.h>
 #include <qmdnsengine/record.h>
 
 #define PARSE_RECORD(r) \
@@ -149,6 +151,8 @@ private Q_SLOTS:
     void testWriteRecordPTR();
     void testWriteRecordSRV();
     void testWriteRecordTXT();
+
+    void testAuthorityCount();
 };
 
 void TestDns::testParseName_data()
@@ -365,5 +369,31 @@ void TestDns::testWriteRecordTXT()
     QCOMPARE(packet, QByteArray(RecordTXT, sizeof(RecordTXT)));
 }
 
+void TestDns::testAuthorityCount()
+{
+    QMdnsEngine::Query query;
+    query.setName(Name);
+    query.setType(QMdnsEngine::ANY);
+    QMdnsEngine::Record record;
+    record.setName(Name);
+    record.setType(QMdnsEngine::A);
+    record.setAddress(Ipv4Address);
+    QMdnsEngine::Message message;
+    message.addQuery(query);
+    message.addRecord(record);
+    message.addRecord(record);
+    message.setAuthorityCount(1);
+
+    // The header should count one answer and one authority record
+    QByteArray packet;
+    QMdnsEngine::toPacket(message, packet);
+    QCOMPARE(packet.mid(6, 4), QByteArray("\x00\x01\x00\x01", 4));
+
+    QMdnsEngine::Message parsed;
+    QVERIFY(QMdnsEngine::fromPacket(packet, parsed));
+    QCOMPARE(parsed.records().count(), 2);
+    QCOMPARE(parsed.authorityCount(), 1);
+}
+
 QTEST_MAIN(TestDns)
 #include "TestDns.moc"
@@ -0,0 +1,127 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QNetworkInterface>
+#include <QObject>
+#include <QSignalSpy>
+#include <QTest>
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/epollserver.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
+#include <qmdnsengine/statistics.h>
+
+Q_DECLARE_METATYPE(QMdnsEngine::Message)
+
+const QByteArray Name = "test.local.";
+
+// Determine whether messages sent to the multicast groups can be received
+static bool multicastAvailable()
+{
+    const auto interfaces = QNetworkInterface::allInterfaces();
+    for (const QNetworkInterface &networkInterface : interfaces) {
+        if ((networkInterface.flags() & QNetworkInterface::CanMulticast) &&
+                (networkInterface.flags() & QNetworkInterface::IsRunning) &&
+                !networkInterface.addressEntries().isEmpty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+class TestEpollServer : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void initTestCase();
+    void testStatistics();
+    void testSuppression();
+    void testManualDispatch();
+};
+
+void TestEpollServer::initTestCase()
+{
+    qRegisterMetaType<QMdnsEngine::Message>("Message");
+}
+
+void TestEpollServer::testStatistics()
+{
+    QMdnsEngine::EpollServer server(QMdnsEngine::EpollServer::ManualDispatch);
+
+    // The counters should match those of Server, less the one for coalescing
+    const QList<QByteArray> names = server.statistics().names();
+    QVERIFY(names.contains("packets_sent"));
+    QVERIFY(names.contains("records_suppressed"));
+    QVERIFY(!names.contains("messages_coalesced"));
+}
+
+void TestEpollServer::testSuppression()
+{
+    QMdnsEngine::EpollServer server(QMdnsEngine::EpollServer::ManualDispatch);
+
+    QMdnsEngine::Record record;
+    record.setName(Name);
+    record.setType(QMdnsEngine::TXT);
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    message.setInterfaceIndex(1000);
+    message.addRecord(record);
+
+    // The same record must not be multicast twice on an interface within a
+    // second
+    server.sendMessageToAll(message);
+    server.sendMessageToAll(message);
+    QCOMPARE(server.statistics().value("records_suppressed"), 1ull);
+    QCOMPARE(server.statistics().value("messages_suppressed"), 1ull);
+}
+
+void TestEpollServer::testManualDispatch()
+{
+    if (!multicastAvailable()) {
+        QSKIP("no multicast interfaces available");
+    }
+
+    QMdnsEngine::EpollServer server(QMdnsEngine::EpollServer::ManualDispatch);
+    QSignalSpy messageReceivedSpy(&server, SIGNAL(messageReceived(Message)));
+
+    QMdnsEngine::Query query;
+    query.setName(Name);
+    query.setType(QMdnsEngine::A);
+    QMdnsEngine::Message message;
+    message.addQuery(query);
+    server.sendMessageToAll(message);
+
+    // The looped back query is only received when events are processed
+    for (int i = 0; i < 50 && messageReceivedSpy.isEmpty(); ++i) {
+        server.processEvents(100);
+    }
+    QVERIFY(!messageReceivedSpy.isEmpty());
+}
+
+QTEST_MAIN(TestEpollServer)
+#include "TestEpollServer.moc"
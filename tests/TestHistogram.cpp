@@ -0,0 +1,105 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QObject>
+#include <QTest>
+
+#include <qmdnsengine/histogram.h>
+
+class TestHistogram : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void testEmpty();
+    void testPercentile();
+    void testAdd();
+    void testPrometheus();
+};
+
+void TestHistogram::testEmpty()
+{
+    QMdnsEngine::Histogram histogram;
+    QCOMPARE(histogram.count(), 0ull);
+    QCOMPARE(histogram.percentile(50), 0ll);
+    QCOMPARE(histogram.mean(), 0.0);
+}
+
+void TestHistogram::testPercentile()
+{
+    QMdnsEngine::Histogram histogram;
+    for (int i = 1; i <= 100; ++i) {
+        histogram.record(i);
+    }
+    histogram.record(10000);
+
+    // Small values are exact and large values are within 2%
+    QCOMPARE(histogram.count(), 101ull);
+    QCOMPARE(histogram.minimum(), 1ll);
+    QCOMPARE(histogram.maximum(), 10000ll);
+    QCOMPARE(histogram.percentile(0), 1ll);
+    QCOMPARE(histogram.percentile(50), 51ll);
+    QCOMPARE(histogram.percentile(100), 10000ll);
+
+    QMdnsEngine::Histogram large;
+    large.record(1000000);
+    large.record(1000001);
+    QVERIFY(qAbs(large.percentile(50) - 1000000) < 20000);
+}
+
+void TestHistogram::testAdd()
+{
+    QMdnsEngine::Histogram histogram;
+    histogram.record(10);
+    QMdnsEngine::Histogram other;
+    other.record(5);
+    other.record(20);
+
+    histogram += other;
+    QCOMPARE(histogram.count(), 3ull);
+    QCOMPARE(histogram.minimum(), 5ll);
+    QCOMPARE(histogram.maximum(), 20ll);
+    QCOMPARE(histogram.sum(), 35ll);
+    QCOMPARE(histogram.percentile(50), 10ll);
+}
+
+void TestHistogram::testPrometheus()
+{
+    QMdnsEngine::Histogram histogram;
+    histogram.record(7);
+
+    QCOMPARE(histogram.toPrometheus("latency"), QByteArray(
+        "# TYPE latency summary\n"
+        "latency{quantile=\"0.5\"} 7\n"
+        "latency{quantile=\"0.9\"} 7\n"
+        "latency{quantile=\"0.99\"} 7\n"
+        "latency{quantile=\"0.999\"} 7\n"
+        "latency_sum 7\n"
+        "latency_count 1\n"
+    ));
+}
+
+QTEST_MAIN(TestHistogram)
+#include "TestHistogram.moc"
@@ -37,6 +37,40 @@
 
 const quint16 Port = 1234;
 
+static QNetworkAddressEntry addressEntry(const QHostAddress &address)
+{
+    QNetworkAddressEntry entry;
+    entry.setIp(address);
+    return entry;
+}
+
+static bool probeSent(TestServer *server, int interfaceIndex)
+{
+    const auto messages = server->receivedMessages();
+    for (const QMdnsEngine::Message &message : messages) {
+        if (!message.isResponse() && message.interfaceIndex() == interfaceIndex) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool addressAnnounced(TestServer *server, int interfaceIndex, const QHostAddress &address)
+{
+    const auto messages = server->receivedMessages();
+    for (const QMdnsEngine::Message &message : messages) {
+        if (message.isResponse() && message.interfaceIndex() == interfaceIndex) {
+            const auto records = message.records();
+            for (const QMdnsEngine::Record &record : records) {
+                if (record.type() == QMdnsEngine::A && record.address() == address) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
+
 class TestHostname : public QObject
 {
     Q_OBJECT
@@ -45,6 +79,8 @@ private Q_SLOTS:
 
     void testAcquire();
     void testAnswer();
+    void testInterfaceAddress();
+    void testInterfacesChanged();
 };
 
 void TestHostname::testAcquire()
@@ -105,5 +141,88 @@ void TestHostname::testAnswer()
     QVERIFY(reply.records().count() > 0);
 }
 
+void TestHostname::testInterfaceAddress()
+{
+    TestServer server;
+    QMdnsEngine::Hostname hostname(&server);
+
+    // Give the server an address for an interface that doesn't exist
+    server.setAddressEntries(1000, {addressEntry(QHostAddress("192.0.2.1"))});
+
+    QTRY_VERIFY(hostname.isRegistered());
+    server.clearReceivedMessages();
+
+    // A query received on the interface should be answered with its address
+    QMdnsEngine::Query query;
+    query.setName(hostname.hostname());
+    query.setType(QMdnsEngine::A);
+    QMdnsEngine::Message message;
+    message.setAddress(QHostAddress("192.0.2.2"));
+    message.setPort(Port);
+    message.setInterfaceIndex(1000);
+    message.addQuery(query);
+    server.deliverMessage(message);
+
+    QTRY_VERIFY(server.receivedMessages().count() > 0);
+    QMdnsEngine::Message reply = server.receivedMessages().at(0);
+    QCOMPARE(reply.records().count(), 1);
+    QCOMPARE(reply.records().at(0).address(), QHostAddress("192.0.2.1"));
+}
+
+void TestHostname::testInterfacesChanged()
+{
+    TestServer server;
+    server.setAddressEntries(1000, {addressEntry(QHostAddress("192.0.2.1"))});
+    server.setAddressEntries(1001, {addressEntry(QHostAddress("192.0.2.2"))});
+    server.setAddressEntries(1002, {addressEntry(QHostAddress("192.0.2.3"))});
+    server.setInterfaceIndices({1000});
+    QMdnsEngine::Hostname hostname(&server);
+    QTRY_VERIFY(hostname.isRegistered());
+    QSignalSpy hostnameChangedSpy(&hostname, SIGNAL(hostnameChanged(QByteArray)));
+    QByteArray name = hostname.hostname();
+    server.clearReceivedMessages();
+
+    // Adding a link should announce the hostname on the existing one right
+    // away and probe the new one without giving up the hostname
+    server.setInterfaceIndices({1000, 1001});
+    emit server.interfacesChanged();
+    QVERIFY(hostname.isRegistered());
+    QVERIFY(addressAnnounced(&server, 1000, QHostAddress("192.0.2.1")));
+    QVERIFY(probeSent(&server, 1001));
+    QVERIFY(!probeSent(&server, 0));
+    QVERIFY(!addressAnnounced(&server, 1001, QHostAddress("192.0.2.2")));
+
+    // Once the probe is done, the new link is given its address
+    QTRY_VERIFY(addressAnnounced(&server, 1001, QHostAddress("192.0.2.2")));
+    QCOMPARE(hostname.hostname(), name);
+    QCOMPARE(hostnameChangedSpy.count(), 0);
+
+    // The host's own replies on a link being probed are not a conflict
+    server.setInterfaceIndices({1000, 1001, 1002});
+    emit server.interfacesChanged();
+    QMdnsEngine::Record record;
+    record.setName(name);
+    record.setType(QMdnsEngine::A);
+    record.setAddress(QHostAddress("192.0.2.3"));
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    message.setInterfaceIndex(1002);
+    message.addRecord(record);
+    server.deliverMessage(message);
+    QVERIFY(hostname.isRegistered());
+
+    // Another host using the name on the new link is
+    record.setAddress(QHostAddress("198.51.100.1"));
+    message = QMdnsEngine::Message();
+    message.setResponse(true);
+    message.setInterfaceIndex(1002);
+    message.addRecord(record);
+    server.deliverMessage(message);
+    QVERIFY(!hostname.isRegistered());
+    QTRY_VERIFY(hostname.isRegistered());
+    QVERIFY(hostname.hostname() != name);
+    QCOMPARE(hostnameChangedSpy.count(), 1);
+}
+
 QTEST_MAIN(TestHostname)
 #include "TestHostname.moc"
@@ -0,0 +1,357 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QMap>
+#include <QNetworkInterface>
+#include <QObject>
+#include <QPointer>
+#include <QSignalSpy>
+#include <QTest>
+#include <QThread>
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
+#include <qmdnsengine/server.h>
+#include <qmdnsengine/statistics.h>
+
+Q_DECLARE_METATYPE(QMdnsEngine::Message)
+
+const QByteArray Name = "test.local.";
+
+// Determine whether messages sent to the multicast groups can be received
+static bool multicastAvailable()
+{
+    const auto interfaces = QNetworkInterface::allInterfaces();
+    for (const QNetworkInterface &networkInterface : interfaces) {
+        if ((networkInterface.flags() & QNetworkInterface::CanMulticast) &&
+                (networkInterface.flags() & QNetworkInterface::IsRunning) &&
+                !networkInterface.addressEntries().isEmpty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static QMdnsEngine::Message response(const QByteArray &name, int size, bool unique = false)
+{
+    QMap<QByteArray, QByteArray> attributes;
+    attributes.insert("a", QByteArray(size, 'x'));
+    QMdnsEngine::Record record;
+    record.setName(name);
+    record.setType(QMdnsEngine::TXT);
+    record.setFlushCache(unique);
+    record.setAttributes(attributes);
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    message.addRecord(record);
+    return message;
+}
+
+static bool recordReceived(const QSignalSpy &spy, const QByteArray &name)
+{
+    for (const QList<QVariant> &arguments : spy) {
+        QMdnsEngine::Message message = arguments.at(0).value<QMdnsEngine::Message>();
+        const auto records = message.records();
+        for (const QMdnsEngine::Record &record : records) {
+            if (record.name() == name) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+static bool messageReceived(const QSignalSpy &spy, const QByteArray &name)
+{
+    for (const QList<QVariant> &arguments : spy) {
+        QMdnsEngine::Message message = arguments.at(0).value<QMdnsEngine::Message>();
+        const auto queries = message.queries();
+        for (const QMdnsEngine::Query &query : queries) {
+            if (query.name() == name) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+class TestNetworkServer : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void initTestCase();
+    void testCoalescing();
+    void testMergedSize();
+    void testUniqueResponse();
+    void testFlush();
+    void testSuppression();
+    void testSuppressionExpiry();
+    void testProbeResponse();
+    void testDedicatedThread();
+    void testDedicatedThreadDestroyed();
+};
+
+void TestNetworkServer::initTestCase()
+{
+    qRegisterMetaType<QMdnsEngine::Message>("Message");
+}
+
+void TestNetworkServer::testCoalescing()
+{
+    QMdnsEngine::Server server;
+    server.setCoalescingInterval(50);
+
+    // Responses sent within the interval should be merged, including one
+    // that only repeats a record
+    server.sendMessageToAll(response("a.local.", 10));
+    server.sendMessageToAll(response("b.local.", 10));
+    server.sendMessageToAll(response("b.local.", 10));
+    QTRY_COMPARE(server.statistics().value("messages_coalesced"), 2ull);
+
+    // Queries are sent immediately instead of being merged into responses
+    QMdnsEngine::Query query;
+    query.setName(Name);
+    query.setType(QMdnsEngine::A);
+    QMdnsEngine::Message message;
+    message.addQuery(query);
+    server.sendMessageToAll(response("c.local.", 10));
+    server.sendMessageToAll(message);
+    QTest::qWait(200);
+    QCOMPARE(server.statistics().value("messages_coalesced"), 2ull);
+}
+
+void TestNetworkServer::testMergedSize()
+{
+    QMdnsEngine::Server server;
+    server.setCoalescingInterval(50);
+
+    // Two of the records fit in a merged message but a third does not
+    server.sendMessageToAll(response("a.local.", 600));
+    server.sendMessageToAll(response("b.local.", 600));
+    server.sendMessageToAll(response("c.local.", 600));
+    QTRY_COMPARE(server.statistics().value("messages_coalesced"), 1ull);
+    QTest::qWait(200);
+    QCOMPARE(server.statistics().value("messages_coalesced"), 1ull);
+}
+
+void TestNetworkServer::testUniqueResponse()
+{
+    QMdnsEngine::Server server;
+    server.setCoalescingInterval(120);
+
+    // A response with only unique records is sent without delay, so sending
+    // it again straight away is caught by the limit on multicasting a record
+    // more than once per second instead of being merged
+    QMdnsEngine::Message message = response("a.local.", 10, true);
+    message.setInterfaceIndex(1000);
+    server.sendMessageToAll(message);
+    server.sendMessageToAll(message);
+    QCOMPARE(server.suppressedRecords(), 1ull);
+
+    QCOMPARE(server.statistics().value("messages_coalesced"), 0ull);
+
+    // A shared record in the response allows it to be held back and merged
+    message.addRecord(response("b.local.", 10).records().at(0));
+    message.setInterfaceIndex(1001);
+    server.sendMessageToAll(message);
+    server.sendMessageToAll(message);
+    QCOMPARE(server.suppressedRecords(), 1ull);
+    QTRY_COMPARE(server.statistics().value("messages_coalesced"), 1ull);
+}
+
+void TestNetworkServer::testFlush()
+{
+    if (!multicastAvailable()) {
+        QSKIP("no multicast interfaces available");
+    }
+
+    QMdnsEngine::Server receiver;
+    QSignalSpy messageReceivedSpy(&receiver, SIGNAL(messageReceived(Message)));
+
+    // A message still waiting to be merged when the server is destroyed
+    // should be sent anyway
+    QMdnsEngine::Server *server = new QMdnsEngine::Server;
+    server->setCoalescingInterval(120);
+    server->sendMessageToAll(response(Name, 10));
+    delete server;
+
+    QTRY_VERIFY(recordReceived(messageReceivedSpy, Name));
+}
+
+void TestNetworkServer::testSuppression()
+{
+    QMdnsEngine::Server server;
+    server.setCoalescingInterval(0);
+
+    // Restricting the responses to an interface keeps the test independent
+    // of the interfaces that are actually present
+    QMdnsEngine::Message message = response("a.local.", 10);
+    message.setInterfaceIndex(1000);
+    server.sendMessageToAll(message);
+    QCOMPARE(server.suppressedRecords(), 0ull);
+
+    // Sending the record again on the same interface should be suppressed
+    server.sendMessageToAll(message);
+    QCOMPARE(server.suppressedRecords(), 1ull);
+    QCOMPARE(server.suppressedMessages(), 1ull);
+
+    // Another interface has not seen the record yet
+    message.setInterfaceIndex(1001);
+    server.sendMessageToAll(message);
+    QCOMPARE(server.suppressedRecords(), 1ull);
+
+    // Only the record that was already sent should be removed when it is
+    // combined with a new one
+    message.addRecord(response("b.local.", 10).records().at(0));
+    server.sendMessageToAll(message);
+    QCOMPARE(server.suppressedRecords(), 2ull);
+    QCOMPARE(server.suppressedMessages(), 1ull);
+}
+
+void TestNetworkServer::testSuppressionExpiry()
+{
+    QMdnsEngine::Server server;
+    server.setCoalescingInterval(0);
+
+    QMdnsEngine::Message message = response("a.local.", 10);
+    message.setInterfaceIndex(1000);
+    server.sendMessageToAll(message);
+
+    // Once a second has passed, the record may be sent again
+    QTest::qWait(1100);
+    server.sendMessageToAll(message);
+    QCOMPARE(server.suppressedRecords(), 0ull);
+}
+
+void TestNetworkServer::testProbeResponse()
+{
+    if (!multicastAvailable()) {
+        QSKIP("no multicast interfaces available");
+    }
+
+    QMdnsEngine::Server server;
+    server.setCoalescingInterval(0);
+    QSignalSpy messageReceivedSpy(&server, SIGNAL(messageReceived(Message)));
+    QMdnsEngine::Server prober;
+    prober.setCoalescingInterval(0);
+
+    QMdnsEngine::Message message = response(Name, 10);
+    server.sendMessageToAll(message);
+    server.sendMessageToAll(message);
+    QCOMPARE(server.suppressedRecords(), 1ull);
+
+    // A query that lists the record as a known answer is not a probe, so
+    // the response to it is still suppressed
+    QMdnsEngine::Query query;
+    query.setName(Name);
+    query.setType(QMdnsEngine::TXT);
+    QMdnsEngine::Message knownAnswerQuery;
+    knownAnswerQuery.addQuery(query);
+    knownAnswerQuery.addRecord(message.records().at(0));
+    prober.sendMessageToAll(knownAnswerQuery);
+    QTRY_VERIFY(messageReceived(messageReceivedSpy, Name));
+    server.sendMessageToAll(message);
+    QCOMPARE(server.suppressedRecords(), 2ull);
+
+    // Send a probe for the name, which carries the proposed record in the
+    // authority section
+    messageReceivedSpy.clear();
+    query.setType(QMdnsEngine::ANY);
+    QMdnsEngine::Message probe;
+    probe.addQuery(query);
+    probe.addRecord(message.records().at(0));
+    probe.setAuthorityCount(1);
+    prober.sendMessageToAll(probe);
+    QTRY_VERIFY(messageReceived(messageReceivedSpy, Name));
+
+    // The response to the probe must not be suppressed
+    server.sendMessageToAll(message);
+    QCOMPARE(server.suppressedRecords(), 2ull);
+}
+
+void TestNetworkServer::testDedicatedThread()
+{
+    if (!multicastAvailable()) {
+        QSKIP("no multicast interfaces available");
+    }
+
+    QMdnsEngine::Server server(QMdnsEngine::Server::DedicatedThread);
+    QSignalSpy messageReceivedSpy(&server, SIGNAL(messageReceived(Message)));
+
+    // Signals must be delivered on the thread that created the server
+    QThread *thread = QThread::currentThread();
+    bool messageThread = true;
+    bool errorThread = true;
+    int errors = 0;
+    connect(&server, &QMdnsEngine::Server::messageReceived, [&]() {
+        messageThread &= QThread::currentThread() == thread;
+    });
+    connect(&server, &QMdnsEngine::Server::error, [&]() {
+        errorThread &= QThread::currentThread() == thread;
+        ++errors;
+    });
+
+    // The looped back query should be received
+    QMdnsEngine::Query query;
+    query.setName(Name);
+    query.setType(QMdnsEngine::A);
+    QMdnsEngine::Message message;
+    message.addQuery(query);
+    server.sendMessageToAll(message);
+    QTRY_VERIFY(messageReceived(messageReceivedSpy, Name));
+    QVERIFY(messageThread);
+
+#ifdef Q_OS_LINUX
+    // Sending out of an interface that doesn't exist fails with an error
+    message.setInterfaceIndex(1000);
+    server.sendMessageToAll(message);
+    QTRY_VERIFY(errors > 0);
+    QVERIFY(errorThread);
+#endif
+}
+
+void TestNetworkServer::testDedicatedThreadDestroyed()
+{
+    QMdnsEngine::Server *server = new QMdnsEngine::Server(QMdnsEngine::Server::DedicatedThread);
+    QPointer<QThread> thread = server->findChild<QThread*>();
+    QVERIFY(thread);
+    QVERIFY(thread != QThread::currentThread());
+    QSignalSpy finishedSpy(thread.data(), SIGNAL(finished()));
+
+    // Destroying the server with messages still queued for the thread should
+    // wait for the thread to finish and clean up after it
+    QMdnsEngine::Message message = response("a.local.", 10);
+    server->sendMessageToAll(message);
+    server->sendMessageToAll(message);
+    delete server;
+    QCOMPARE(finishedSpy.count(), 1);
+    QVERIFY(thread.isNull());
+}
+
+QTEST_MAIN(TestNetworkServer)
+#include "TestNetworkServer.moc"
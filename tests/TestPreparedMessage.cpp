@@ -0,0 +1,97 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QObject>
+#include <QTest>
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/mdns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/preparedmessage.h>
+#include <qmdnsengine/record.h>
+
+#include "common/testserver.h"
+
+const QByteArray Name = "Test.local.";
+const QHostAddress Address("127.0.0.1");
+
+class TestPreparedMessage : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void testPacket();
+    void testSend();
+};
+
+void TestPreparedMessage::testPacket()
+{
+    QVERIFY(QMdnsEngine::PreparedMessage().isNull());
+
+    QMdnsEngine::Record record;
+    record.setName(Name);
+    record.setType(QMdnsEngine::A);
+    record.setAddress(Address);
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    message.addRecord(record);
+
+    QByteArray packet;
+    QMdnsEngine::toPacket(message, packet);
+
+    // The packet should match the serialized message and be unaffected by
+    // changes to the destination
+    QMdnsEngine::PreparedMessage prepared(message);
+    QVERIFY(!prepared.isNull());
+    QCOMPARE(prepared.packet(), packet);
+    prepared.setAddress(QMdnsEngine::MdnsIpv6Address);
+    prepared.setPort(QMdnsEngine::MdnsPort);
+    QCOMPARE(prepared.packet(), packet);
+    QCOMPARE(prepared.message().address(), QMdnsEngine::MdnsIpv6Address);
+    QCOMPARE(prepared.message().port(), QMdnsEngine::MdnsPort);
+}
+
+void TestPreparedMessage::testSend()
+{
+    TestServer server;
+
+    QMdnsEngine::Record record;
+    record.setName(Name);
+    record.setType(QMdnsEngine::A);
+    record.setAddress(Address);
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    message.addRecord(record);
+
+    // The default implementation should send the message itself
+    server.sendPreparedMessageToAll(QMdnsEngine::PreparedMessage(message));
+    QVERIFY(server.receivedMessages().count() > 0);
+    QMdnsEngine::Record cachedRecord;
+    QVERIFY(server.cache()->lookupRecord(Name, QMdnsEngine::A, cachedRecord));
+    QCOMPARE(cachedRecord.address(), Address);
+}
+
+QTEST_MAIN(TestPreparedMessage)
+#include "TestPreparedMessage.moc"
@@ -26,6 +26,7 @@
 #include <QTest>
 
 #include <qmdnsengine/dns.h>
+#include <qmdnsengine/manualclock.h>
 #include <qmdnsengine/message.h>
 #include <qmdnsengine/prober.h>
 #include <qmdnsengine/record.h>
@@ -42,6 +43,7 @@ class TestProber : public QObject
 private Q_SLOTS:
 
     void testProbe();
+    void testClock();
 };
 
 void TestProber::testProbe()
@@ -65,5 +67,25 @@ void TestProber::testProbe()
     QVERIFY(nameConfirmedSpy.at(0).at(0).toByteArray() != Name);
 }
 
+void TestProber::testClock()
+{
+    QMdnsEngine::Record record;
+    record.setName(Name);
+    record.setType(Type);
+
+    QMdnsEngine::ManualClock clock;
+    TestServer server;
+    server.setClock(&clock);
+    QMdnsEngine::Prober prober(&server, record);
+    QSignalSpy nameConfirmedSpy(&prober, SIGNAL(nameConfirmed(QByteArray)));
+
+    // The name should be confirmed once two seconds have passed on the clock
+    clock.advance(1999);
+    QCOMPARE(nameConfirmedSpy.count(), 0);
+    clock.advance(1);
+    QCOMPARE(nameConfirmedSpy.count(), 1);
+    QCOMPARE(nameConfirmedSpy.at(0).at(0).toByteArray(), Name);
+}
+
 QTEST_MAIN(TestProber)
 #include "TestProber.moc"
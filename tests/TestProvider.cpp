@@ -26,11 +26,16 @@
 
 #include <qmdnsengine/dns.h>
 #include <qmdnsengine/hostname.h>
+#include <qmdnsengine/mdns.h>
+#include <qmdnsengine/message.h>
 #include <qmdnsengine/provider.h>
+#include <qmdnsengine/query.h>
 #include <qmdnsengine/record.h>
 #include <qmdnsengine/service.h>
+#include <qmdnsengine/statistics.h>
 
 #include "common/testserver.h"
+#include "common/util.h"
 
 const QByteArray Name = "Test";
 const QByteArray Type = "_test._tcp.local.";
@@ -46,6 +51,8 @@ class TestProvider : public QObject
 private Q_SLOTS:
 
     void testProvider();
+    void testInterfacesChanged();
+    void testDuplicateSuppression();
 };
 
 void TestProvider::testProvider()
@@ -73,5 +80,72 @@ void TestProvider::testProvider()
     QCOMPARE(record.attributes(), service.attributes());
 }
 
+void TestProvider::testInterfacesChanged()
+{
+    TestServer server;
+    QMdnsEngine::Hostname hostname(&server);
+    QMdnsEngine::Provider provider(&server, &hostname);
+
+    QMdnsEngine::Service service;
+    service.setName(Name);
+    service.setType(Type);
+    service.setPort(Port);
+    provider.update(service);
+
+    // Wait for the service to be announced
+    QMdnsEngine::Record record;
+    QTRY_VERIFY(server.cache()->lookupRecord(Fqdn, QMdnsEngine::SRV, record));
+
+    // A change to the interfaces should cause the records to be announced
+    server.clearReceivedMessages();
+    emit server.interfacesChanged();
+    QVERIFY(recordReceived(&server, Fqdn, QMdnsEngine::SRV));
+    QVERIFY(recordReceived(&server, Type, QMdnsEngine::PTR));
+}
+
+void TestProvider::testDuplicateSuppression()
+{
+    TestServer server;
+    QMdnsEngine::Hostname hostname(&server);
+    QMdnsEngine::Provider provider(&server, &hostname);
+
+    QMdnsEngine::Service service;
+    service.setName(Name);
+    service.setType(Type);
+    service.setPort(Port);
+    provider.update(service);
+
+    // Wait for the service to be announced
+    QMdnsEngine::Record record;
+    QTRY_VERIFY(server.cache()->lookupRecord(Type, QMdnsEngine::PTR, record));
+
+    QMdnsEngine::Query query;
+    query.setName(Type);
+    query.setType(QMdnsEngine::PTR);
+    QMdnsEngine::Message message;
+    message.setAddress(QMdnsEngine::MdnsIpv4Address);
+    message.setPort(QMdnsEngine::MdnsPort);
+    message.addQuery(query);
+
+    // A query that nobody else answers should receive a (delayed) reply
+    server.clearReceivedMessages();
+    server.deliverMessage(message);
+    QVERIFY(server.receivedMessages().isEmpty());
+    QTRY_VERIFY(recordReceived(&server, Type, QMdnsEngine::PTR));
+
+    // The reply should not be sent if another responder answers first
+    QMdnsEngine::Message response;
+    response.setAddress(QMdnsEngine::MdnsIpv4Address);
+    response.setPort(QMdnsEngine::MdnsPort);
+    response.setResponse(true);
+    response.addRecord(record);
+    server.clearReceivedMessages();
+    server.deliverMessage(message);
+    server.deliverMessage(response);
+    QTest::qWait(150);
+    QVERIFY(!recordReceived(&server, Type, QMdnsEngine::PTR));
+    QCOMPARE(provider.statistics().value("records_suppressed"), 1ull);
+}
+
 QTEST_MAIN(TestProvider)
 #include "TestProvider.moc"
@@ -27,6 +27,8 @@
 #include <QTest>
 
 #include <qmdnsengine/dns.h>
+#include <qmdnsengine/histogram.h>
+#include <qmdnsengine/manualclock.h>
 #include <qmdnsengine/message.h>
 #include <qmdnsengine/record.h>
 #include <qmdnsengine/resolver.h>
@@ -47,6 +49,7 @@ private Q_SLOTS:
 
     void initTestCase();
     void testResolver();
+    void testLatency();
 };
 
 void TestResolver::initTestCase()
@@ -80,5 +83,29 @@ void TestResolver::testResolver()
     QCOMPARE(resolvedSpy.at(0).at(0).value<QHostAddress>(), Address);
 }
 
+void TestResolver::testLatency()
+{
+    QMdnsEngine::ManualClock clock;
+    TestServer server;
+    server.setClock(&clock);
+    QMdnsEngine::Resolver resolver(&server, Name);
+
+    // Answer the query after 25 ms
+    clock.advance(25);
+    QMdnsEngine::Record record;
+    record.setName(Name);
+    record.setType(QMdnsEngine::A);
+    record.setAddress(Address);
+    QMdnsEngine::Message message;
+    message.setResponse(true);
+    message.addRecord(record);
+    server.deliverMessage(message);
+
+    // Ensure the time taken was recorded once
+    QMdnsEngine::Histogram histogram = server.latency(QMdnsEngine::AbstractServer::ResolveLatency);
+    QCOMPARE(histogram.count(), 1ull);
+    QCOMPARE(histogram.maximum(), 25ll);
+}
+
 QTEST_MAIN(TestResolver)
 #include "TestResolver.moc"
@@ -0,0 +1,101 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QObject>
+#include <QTest>
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/record.h>
+#include <qmdnsengine/service.h>
+
+class TestService : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void testPriorities();
+    void testWeights();
+
+private:
+
+    static QMdnsEngine::Record createTarget(const QByteArray &target, quint16 priority, quint16 weight);
+};
+
+void TestService::testPriorities()
+{
+    QMdnsEngine::Service service;
+    service.setTargets({
+        createTarget("backup.local.", 10, 0),
+        createTarget("primary.local.", 0, 0)
+    });
+
+    // Lower priorities always come first
+    QList<QMdnsEngine::Record> targets = service.orderedTargets();
+    QCOMPARE(targets.count(), 2);
+    QCOMPARE(targets.at(0).target(), QByteArray("primary.local."));
+    QCOMPARE(targets.at(1).target(), QByteArray("backup.local."));
+}
+
+void TestService::testWeights()
+{
+    QMdnsEngine::Service service;
+    service.setTargets({
+        createTarget("light.local.", 0, 10),
+        createTarget("heavy.local.", 0, 30),
+        createTarget("idle.local.", 0, 0)
+    });
+
+    // Within a priority, the heavier record should come first about three
+    // times in four and the record with no weight only rarely (one time in
+    // the sum of the weights plus one)
+    const int Rounds = 2000;
+    int heavy = 0;
+    int idle = 0;
+    for (int i = 0; i < Rounds; ++i) {
+        QList<QMdnsEngine::Record> targets = service.orderedTargets();
+        QCOMPARE(targets.count(), 3);
+        if (targets.at(0).target() == "heavy.local.") {
+            ++heavy;
+        } else if (targets.at(0).target() == "idle.local.") {
+            ++idle;
+        }
+    }
+    QVERIFY(heavy > Rounds * 65 / 100 && heavy < Rounds * 85 / 100);
+    QVERIFY(idle < Rounds * 5 / 100);
+}
+
+QMdnsEngine::Record TestService::createTarget(const QByteArray &target, quint16 priority, quint16 weight)
+{
+    QMdnsEngine::Record record;
+    record.setName("Test._test._tcp.local.");
+    record.setType(QMdnsEngine::SRV);
+    record.setTarget(target);
+    record.setPriority(priority);
+    record.setWeight(weight);
+    return record;
+}
+
+QTEST_MAIN(TestService)
+#include "TestService.moc"
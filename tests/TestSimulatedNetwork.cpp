@@ -0,0 +1,215 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include <QList>
+#include <QObject>
+#include <QTest>
+
+#include <qmdnsengine/browser.h>
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/hostname.h>
+#include <qmdnsengine/mdns.h>
+#include <qmdnsengine/message.h>
+#include <qmdnsengine/provider.h>
+#include <qmdnsengine/query.h>
+#include <qmdnsengine/service.h>
+
+#include "common/simulatednetwork.h"
+
+const QByteArray Name = "Test.local.";
+const QByteArray Type = "_test._tcp.local.";
+
+// Size of the simulation in testConvergence()
+const int ProviderCount = 50;
+const int BrowserCount = 10;
+
+class TestSimulatedNetwork : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void testMulticast();
+    void testUnicast();
+    void testLatency();
+    void testLoss();
+    void testReordering();
+    void testConvergence();
+};
+
+static QMdnsEngine::Message createQuery(quint16 transactionId = 0)
+{
+    QMdnsEngine::Query query;
+    query.setName(Name);
+    query.setType(QMdnsEngine::A);
+    QMdnsEngine::Message message;
+    message.setAddress(QMdnsEngine::MdnsIpv4Address);
+    message.setPort(QMdnsEngine::MdnsPort);
+    message.setTransactionId(transactionId);
+    message.addQuery(query);
+    return message;
+}
+
+static void collect(SimulatedServer *server, QList<QMdnsEngine::Message> *messages)
+{
+    QObject::connect(server, &SimulatedServer::messageReceived, [messages](const QMdnsEngine::Message &message) {
+        messages->append(message);
+    });
+}
+
+void TestSimulatedNetwork::testMulticast()
+{
+    SimulatedNetwork network;
+    SimulatedServer server1(&network);
+    SimulatedServer server2(&network);
+    QList<QMdnsEngine::Message> messages1;
+    QList<QMdnsEngine::Message> messages2;
+    collect(&server1, &messages1);
+    collect(&server2, &messages2);
+
+    // Every endpoint, including the sender, should receive the message
+    server1.sendMessageToAll(createQuery());
+    QCOMPARE(network.advance(0), 2);
+    QCOMPARE(messages1.count(), 1);
+    QCOMPARE(messages2.count(), 1);
+    QCOMPARE(messages2.at(0).address(), server1.ipv4Address());
+    QCOMPARE(messages2.at(0).queries().at(0).name(), Name);
+    QCOMPARE(network.packetsSent(), 1ull);
+    QCOMPARE(network.packetsDelivered(), 2ull);
+}
+
+void TestSimulatedNetwork::testUnicast()
+{
+    SimulatedNetwork network;
+    SimulatedServer server1(&network);
+    SimulatedServer server2(&network);
+    QList<QMdnsEngine::Message> messages1;
+    QList<QMdnsEngine::Message> messages2;
+    collect(&server1, &messages1);
+    collect(&server2, &messages2);
+
+    // Only the endpoint with the address should receive the message
+    QMdnsEngine::Message message = createQuery();
+    message.setAddress(server2.ipv6Address());
+    server1.sendMessage(message);
+    network.advanceUntilIdle();
+    QCOMPARE(messages1.count(), 0);
+    QCOMPARE(messages2.count(), 1);
+    QCOMPARE(messages2.at(0).address(), server1.ipv6Address());
+}
+
+void TestSimulatedNetwork::testLatency()
+{
+    SimulatedNetwork network;
+    network.setLatency(5, 5);
+    SimulatedServer server(&network);
+    QList<QMdnsEngine::Message> messages;
+    collect(&server, &messages);
+
+    // The message should only arrive once the clock reaches its latency
+    server.sendMessageToAll(createQuery());
+    QCOMPARE(network.advance(4), 0);
+    QCOMPARE(network.advance(1), 1);
+    QCOMPARE(network.elapsed(), 5ll);
+    QCOMPARE(messages.count(), 1);
+}
+
+void TestSimulatedNetwork::testLoss()
+{
+    SimulatedNetwork network;
+    network.setLoss(1);
+    SimulatedServer server(&network);
+
+    server.sendMessageToAll(createQuery());
+    QCOMPARE(network.advanceUntilIdle(), 0);
+    QCOMPARE(network.packetsDropped(), 1ull);
+}
+
+void TestSimulatedNetwork::testReordering()
+{
+    const int Count = 100;
+    QList<quint16> orders[2];
+
+    // The same seed should produce the same order, which should differ from
+    // the order the messages were sent in
+    for (int run = 0; run < 2; ++run) {
+        SimulatedNetwork network(42);
+        network.setLatency(1, 10);
+        network.setReordering(0.2);
+        SimulatedServer server(&network);
+        QList<QMdnsEngine::Message> messages;
+        collect(&server, &messages);
+        for (int i = 0; i < Count; ++i) {
+            server.sendMessageToAll(createQuery(i));
+        }
+        QCOMPARE(network.advanceUntilIdle(), Count);
+        for (const QMdnsEngine::Message &message : messages) {
+            orders[run].append(message.transactionId());
+        }
+    }
+    QCOMPARE(orders[0], orders[1]);
+    QList<quint16> sorted = orders[0];
+    std::sort(sorted.begin(), sorted.end());
+    QVERIFY(orders[0] != sorted);
+}
+
+void TestSimulatedNetwork::testConvergence()
+{
+    SimulatedNetwork network;
+    network.setLatency(1, 5);
+    QObject root;
+
+    // Give each provider and browser an endpoint of its own
+    for (int i = 0; i < ProviderCount; ++i) {
+        SimulatedServer *server = new SimulatedServer(&network, &root);
+        QMdnsEngine::Hostname *hostname = new QMdnsEngine::Hostname(server, server);
+        QMdnsEngine::Provider *provider = new QMdnsEngine::Provider(server, hostname, server);
+        QMdnsEngine::Service service;
+        service.setName("Test " + QByteArray::number(i));
+        service.setType(Type);
+        service.setPort(1234);
+        provider->update(service);
+    }
+    QList<int> counts;
+    for (int i = 0; i < BrowserCount; ++i) {
+        SimulatedServer *server = new SimulatedServer(&network, &root);
+        QMdnsEngine::Browser *browser = new QMdnsEngine::Browser(server, Type, nullptr, server);
+        counts.append(0);
+        connect(browser, &QMdnsEngine::Browser::serviceAdded, [&counts, i]() {
+            ++counts[i];
+        });
+    }
+
+    // Probing takes two seconds for the hostname and two for the service, so
+    // every browser should know about every service well within ten
+    network.advance(10 * 1000);
+    for (int count : counts) {
+        QCOMPARE(count, ProviderCount);
+    }
+}
+
+QTEST_MAIN(TestSimulatedNetwork)
+#include "TestSimulatedNetwork.moc"
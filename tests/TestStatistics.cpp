@@ -0,0 +1,80 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QObject>
+#include <QTest>
+
+#include <qmdnsengine/statistics.h>
+
+class TestStatistics : public QObject
+{
+    Q_OBJECT
+
+private Q_SLOTS:
+
+    void testValues();
+    void testAdd();
+    void testPrometheus();
+};
+
+void TestStatistics::testValues()
+{
+    QMdnsEngine::Statistics statistics;
+    statistics.setValue("b", 2);
+    statistics.setValue("a", 1);
+    statistics.setValue("b", 3);
+
+    // Counters should keep the order they were added in
+    QCOMPARE(statistics.names(), QList<QByteArray>({"b", "a"}));
+    QCOMPARE(statistics.value("a"), 1ull);
+    QCOMPARE(statistics.value("b"), 3ull);
+    QCOMPARE(statistics.value("c"), 0ull);
+}
+
+void TestStatistics::testAdd()
+{
+    QMdnsEngine::Statistics statistics;
+    statistics.setValue("a", 1);
+    QMdnsEngine::Statistics other;
+    other.setValue("a", 2);
+    other.setValue("b", 3);
+
+    statistics += other;
+    QCOMPARE(statistics.value("a"), 3ull);
+    QCOMPARE(statistics.value("b"), 3ull);
+}
+
+void TestStatistics::testPrometheus()
+{
+    QMdnsEngine::Statistics statistics;
+    statistics.setValue("packets_sent", 42);
+
+    QCOMPARE(statistics.toPrometheus("mdns"), QByteArray(
+        "# TYPE mdns_packets_sent_total counter\n"
+        "mdns_packets_sent_total 42\n"
+    ));
+}
+
+QTEST_MAIN(TestStatistics)
+#include "TestStatistics.moc"
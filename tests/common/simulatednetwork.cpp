@@ -0,0 +1,263 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#include <QString>
+
+#include <qmdnsengine/dns.h>
+#include <qmdnsengine/mdns.h>
+#include <qmdnsengine/preparedmessage.h>
+
+#include "simulatednetwork.h"
+
+SimulatedServer::SimulatedServer(SimulatedNetwork *network, QObject *parent)
+    : QMdnsEngine::AbstractServer(parent),
+      mNetwork(network),
+      mIndex(network->attach(this))
+{
+    setClock(network->clock());
+}
+
+SimulatedServer::~SimulatedServer()
+{
+    if (mNetwork) {
+        mNetwork->detach(mIndex);
+    }
+}
+
+QHostAddress SimulatedServer::ipv4Address() const
+{
+    // Each endpoint is given addresses derived from its index
+    return QHostAddress(0x0a000000 + mIndex + 1);
+}
+
+QHostAddress SimulatedServer::ipv6Address() const
+{
+    return QHostAddress(QString("fd00::%1").arg(mIndex + 1, 0, 16));
+}
+
+void SimulatedServer::sendMessage(const QMdnsEngine::Message &message)
+{
+    if (mNetwork) {
+        mNetwork->send(mIndex, message, false, QByteArray());
+    }
+}
+
+void SimulatedServer::sendMessageToAll(const QMdnsEngine::Message &message)
+{
+    if (mNetwork) {
+        mNetwork->send(mIndex, message, true, QByteArray());
+    }
+}
+
+void SimulatedServer::sendPreparedMessage(const QMdnsEngine::PreparedMessage &message)
+{
+    if (mNetwork) {
+        mNetwork->send(mIndex, message.message(), false, message.packet());
+    }
+}
+
+void SimulatedServer::sendPreparedMessageToAll(const QMdnsEngine::PreparedMessage &message)
+{
+    if (mNetwork) {
+        mNetwork->send(mIndex, message.message(), true, message.packet());
+    }
+}
+
+void SimulatedServer::deliverPacket(const QByteArray &packet, const QHostAddress &address)
+{
+    QMdnsEngine::Message message;
+    if (QMdnsEngine::fromPacket(packet, message)) {
+        message.setAddress(address);
+        message.setPort(QMdnsEngine::MdnsPort);
+        message.setInterfaceIndex(1);
+        emit messageReceived(message);
+    }
+}
+
+SimulatedNetwork::SimulatedNetwork(quint32 seed, QObject *parent)
+    : QObject(parent),
+      mGenerator(seed),
+      mLoss(0),
+      mMinimumLatency(0),
+      mMaximumLatency(0),
+      mReordering(0),
+      mPacketsSent(0),
+      mBytesSent(0),
+      mPacketsDelivered(0),
+      mPacketsDropped(0)
+{
+}
+
+void SimulatedNetwork::setLoss(double probability)
+{
+    mLoss = probability;
+}
+
+void SimulatedNetwork::setLatency(int minimum, int maximum)
+{
+    mMinimumLatency = minimum;
+    mMaximumLatency = qMax(minimum, maximum);
+}
+
+void SimulatedNetwork::setReordering(double probability)
+{
+    mReordering = probability;
+}
+
+QMdnsEngine::ManualClock *SimulatedNetwork::clock()
+{
+    return &mClock;
+}
+
+qint64 SimulatedNetwork::elapsed() const
+{
+    return mClock.elapsed();
+}
+
+int SimulatedNetwork::advance(qint64 msec)
+{
+    quint64 delivered = mPacketsDelivered;
+    mClock.advance(msec);
+    return mPacketsDelivered - delivered;
+}
+
+int SimulatedNetwork::advanceUntilIdle()
+{
+    int count = 0;
+    while (!mPending.isEmpty()) {
+        count += advance(mPending.firstKey() - mClock.elapsed());
+    }
+    return count;
+}
+
+int SimulatedNetwork::pendingCount() const
+{
+    int count = 0;
+    for (int value : mPending) {
+        count += value;
+    }
+    return count;
+}
+
+quint64 SimulatedNetwork::packetsSent() const
+{
+    return mPacketsSent;
+}
+
+quint64 SimulatedNetwork::bytesSent() const
+{
+    return mBytesSent;
+}
+
+quint64 SimulatedNetwork::packetsDelivered() const
+{
+    return mPacketsDelivered;
+}
+
+quint64 SimulatedNetwork::packetsDropped() const
+{
+    return mPacketsDropped;
+}
+
+int SimulatedNetwork::attach(SimulatedServer *server)
+{
+    mServers.append(server);
+    return mServers.count() - 1;
+}
+
+void SimulatedNetwork::detach(int index)
+{
+    // The slot is kept so that the addresses of other endpoints don't change
+    mServers[index] = nullptr;
+}
+
+void SimulatedNetwork::send(int sender, const QMdnsEngine::Message &message, bool toAll, const QByteArray &preparedPacket)
+{
+    QByteArray packet = preparedPacket;
+    if (packet.isNull()) {
+        QMdnsEngine::toPacket(message, packet);
+    }
+    ++mPacketsSent;
+    mBytesSent += packet.size();
+
+    // Receivers see the address of the sender for the protocol in use
+    SimulatedServer *server = mServers.at(sender);
+    bool ipv6 = !toAll && message.address().protocol() == QAbstractSocket::IPv6Protocol;
+    QHostAddress address = ipv6 ? server->ipv6Address() : server->ipv4Address();
+
+    if (toAll || message.address() == QMdnsEngine::MdnsIpv4Address ||
+            message.address() == QMdnsEngine::MdnsIpv6Address) {
+        // Copy the list since a receiver may create or destroy endpoints
+        const QList<SimulatedServer*> servers = mServers;
+        for (SimulatedServer *receiver : servers) {
+            if (receiver) {
+                schedule(receiver, packet, address);
+            }
+        }
+    } else {
+        for (SimulatedServer *receiver : mServers) {
+            if (receiver && (receiver->ipv4Address() == message.address() ||
+                    receiver->ipv6Address() == message.address())) {
+                schedule(receiver, packet, address);
+                break;
+            }
+        }
+    }
+}
+
+void SimulatedNetwork::schedule(SimulatedServer *receiver, const QByteArray &packet, const QHostAddress &address)
+{
+    if (chance(mLoss)) {
+        ++mPacketsDropped;
+        return;
+    }
+    qint64 latency = std::uniform_int_distribution<int>(mMinimumLatency, mMaximumLatency)(mGenerator);
+    if (chance(mReordering)) {
+        latency += mMaximumLatency;
+    }
+    // Deliveries due at the same time are made in the order they were sent
+    // since the clock runs them in the order they were scheduled
+    qint64 time = mClock.elapsed() + latency;
+    ++mPending[time];
+    Delivery delivery = {receiver, packet, address};
+    mClock.schedule(latency, [this, delivery, time]() {
+        deliver(delivery, time);
+    });
+}
+
+void SimulatedNetwork::deliver(const Delivery &delivery, qint64 time)
+{
+    if (--mPending[time] == 0) {
+        mPending.remove(time);
+    }
+    if (delivery.receiver) {
+        ++mPacketsDelivered;
+        delivery.receiver->deliverPacket(delivery.packet, delivery.address);
+    }
+}
+
+bool SimulatedNetwork::chance(double probability)
+{
+    return probability > 0 && std::uniform_real_distribution<double>(0, 1)(mGenerator) < probability;
+}
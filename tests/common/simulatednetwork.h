@@ -0,0 +1,177 @@
+/*
+ * The MIT License (MIT)
+ *
+ * Copyright (c) 2017 Nathan Osman
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to
+ * deal in the Software without restriction, including without limitation the
+ * rights to use, copy, modify, merge, publish, distribute, sublicense, and/or
+ * sell copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING
+ * FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+ * IN THE SOFTWARE.
+ */
+
+#ifndef COMMON_SIMULATEDNETWORK_H
+#define COMMON_SIMULATEDNETWORK_H
+
+#include <random>
+
+#include <QByteArray>
+#include <QHostAddress>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QPointer>
+
+#include <qmdnsengine/abstractserver.h>
+#include <qmdnsengine/manualclock.h>
+#include <qmdnsengine/message.h>
+
+class SimulatedNetwork;
+
+/**
+ * @brief Endpoint attached to a simulated network
+ *
+ * Messages sent to the mDNS multicast address (or with sendMessageToAll())
+ * are delivered to every endpoint on the network, including the sender, as
+ * they would be with multicast loopback enabled. Other messages are delivered
+ * to the endpoint with the destination address.
+ */
+class SimulatedServer : public QMdnsEngine::AbstractServer
+{
+    Q_OBJECT
+
+public:
+
+    explicit SimulatedServer(SimulatedNetwork *network, QObject *parent = 0);
+    virtual ~SimulatedServer();
+
+    QHostAddress ipv4Address() const;
+    QHostAddress ipv6Address() const;
+
+    virtual void sendMessage(const QMdnsEngine::Message &message);
+    virtual void sendMessageToAll(const QMdnsEngine::Message &message);
+    virtual void sendPreparedMessage(const QMdnsEngine::PreparedMessage &message);
+    virtual void sendPreparedMessageToAll(const QMdnsEngine::PreparedMessage &message);
+
+private:
+
+    friend class SimulatedNetwork;
+
+    void deliverPacket(const QByteArray &packet, const QHostAddress &address);
+
+    QPointer<SimulatedNetwork> mNetwork;
+    int mIndex;
+};
+
+/**
+ * @brief Deterministic in-memory network for any number of endpoints
+ *
+ * Every message is encoded when it is sent and decoded separately by each
+ * receiver. Delivery is driven by a virtual clock, which is also used by
+ * every object created for an endpoint: a message sent at time T with a
+ * latency of L milliseconds is delivered by the advance() call that moves
+ * the clock past T + L, in order with any timers that are due. Loss,
+ * latency and reordering are drawn from a generator with a fixed seed, so a
+ * simulation produces the same results every time it is run.
+ */
+class SimulatedNetwork : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    explicit SimulatedNetwork(quint32 seed = 1, QObject *parent = 0);
+
+    /**
+     * @brief Set the probability of each delivery being dropped
+     */
+    void setLoss(double probability);
+
+    /**
+     * @brief Set the range of time each delivery takes in milliseconds
+     */
+    void setLatency(int minimum, int maximum);
+
+    /**
+     * @brief Set the probability of a delivery being held back behind later ones
+     *
+     * A delivery that is reordered takes an additional maximum latency.
+     */
+    void setReordering(double probability);
+
+    /**
+     * @brief Retrieve the virtual clock
+     */
+    QMdnsEngine::ManualClock *clock();
+
+    /**
+     * @brief Retrieve the current time of the virtual clock in milliseconds
+     */
+    qint64 elapsed() const;
+
+    /**
+     * @brief Advance the virtual clock, delivering messages that become due
+     * @return number of messages delivered
+     */
+    int advance(qint64 msec);
+
+    /**
+     * @brief Advance the virtual clock until no messages are left in transit
+     * @return number of messages delivered
+     */
+    int advanceUntilIdle();
+
+    int pendingCount() const;
+
+    quint64 packetsSent() const;
+    quint64 bytesSent() const;
+    quint64 packetsDelivered() const;
+    quint64 packetsDropped() const;
+
+private:
+
+    friend class SimulatedServer;
+
+    struct Delivery
+    {
+        QPointer<SimulatedServer> receiver;
+        QByteArray packet;
+        QHostAddress address;
+    };
+
+    int attach(SimulatedServer *server);
+    void detach(int index);
+    void send(int sender, const QMdnsEngine::Message &message, bool toAll, const QByteArray &packet);
+    void schedule(SimulatedServer *receiver, const QByteArray &packet, const QHostAddress &address);
+    void deliver(const Delivery &delivery, qint64 time);
+    bool chance(double probability);
+
+    std::mt19937 mGenerator;
+    double mLoss;
+    int mMinimumLatency;
+    int mMaximumLatency;
+    double mReordering;
+
+    QMdnsEngine::ManualClock mClock;
+    QMap<qint64, int> mPending;
+    QList<SimulatedServer*> mServers;
+
+    quint64 mPacketsSent;
+    quint64 mBytesSent;
+    quint64 mPacketsDelivered;
+    quint64 mPacketsDropped;
+};
+
+#endif // COMMON_SIMULATEDNETWORK_H
@@ -44,6 +44,27 @@ void TestServer::sendMessageToAll(const QMdnsEngine::Message &message)
     saveMessage(ipv6Message);
 }
 
+QList<QNetworkAddressEntry> TestServer::addressEntries(int interfaceIndex) const
+{
+    auto i = mAddresses.constFind(interfaceIndex);
+    return i == mAddresses.constEnd() ? AbstractServer::addressEntries(interfaceIndex) : i.value();
+}
+
+QList<int> TestServer::interfaceIndices() const
+{
+    return mIndices;
+}
+
+void TestServer::setAddressEntries(int interfaceIndex, const QList<QNetworkAddressEntry> &entries)
+{
+    mAddresses.insert(interfaceIndex, entries);
+}
+
+void TestServer::setInterfaceIndices(const QList<int> &indices)
+{
+    mIndices = indices;
+}
+
 void TestServer::deliverMessage(const QMdnsEngine::Message &message)
 {
     emit messageReceived(message);
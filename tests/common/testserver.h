@@ -25,7 +25,9 @@
 #ifndef COMMON_TESTSERVER_H
 #define COMMON_TESTSERVER_H
 
+#include <QHash>
 #include <QList>
+#include <QNetworkAddressEntry>
 
 #include <qmdnsengine/abstractserver.h>
 #include <qmdnsengine/cache.h>
@@ -42,6 +44,11 @@ public:
 
     virtual void sendMessage(const QMdnsEngine::Message &message);
     virtual void sendMessageToAll(const QMdnsEngine::Message &message);
+    virtual QList<QNetworkAddressEntry> addressEntries(int interfaceIndex) const;
+    virtual QList<int> interfaceIndices() const;
+
+    void setAddressEntries(int interfaceIndex, const QList<QNetworkAddressEntry> &entries);
+    void setInterfaceIndices(const QList<int> &indices);
 
     void deliverMessage(const QMdnsEngine::Message &message);
 
@@ -55,6 +62,8 @@ private:
     void saveMessage(const QMdnsEngine::Message &message);
 
     QList<QMdnsEngine::Message> mMessages;
+    QHash<int, QList<QNetworkAddressEntry>> mAddresses;
+    QList<int> mIndices;
     QMdnsEngine::Cache mCache;
 };
 
@@ -24,6 +24,7 @@
 
 #include <qmdnsengine/message.h>
 #include <qmdnsengine/query.h>
+#include <qmdnsengine/record.h>
 
 #include "util.h"
 
@@ -42,3 +43,19 @@ bool queryReceived(TestServer *server, const QByteArray &name, quint16 type)
     }
     return false;
 }
+
+bool recordReceived(TestServer *server, const QByteArray &name, quint16 type)
+{
+    const auto messages = server->receivedMessages();
+    for (const QMdnsEngine::Message &message : messages) {
+        if (message.isResponse()) {
+            const auto records = message.records();
+            for (const QMdnsEngine::Record &record : records) {
+                if (record.name() == name && record.type() == type) {
+                    return true;
+                }
+            }
+        }
+    }
+    return false;
+}
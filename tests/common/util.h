@@ -30,5 +30,6 @@
 #include "testserver.h"
 
 bool queryReceived(TestServer *server, const QByteArray &name, quint16 type);
+bool recordReceived(TestServer *server, const QByteArray &name, quint16 type);
 
 #endif // COMMON_UTIL_H